@@ -10,8 +10,10 @@
 #include <lib_config/Bundle.hpp>
 #include <string>  
 #include <limits>
+#include <algorithm>
 
 #include "PluginHelper.hpp"
+#include "FlatLayout.hpp"
 #include <lib_config/YAMLConfiguration.hpp>
 
 using namespace orocos_cpp;
@@ -138,86 +140,68 @@ bool applyConfOnTypelibEnum(Typelib::Value &value, const SimpleConfigValue& conf
     return true;
 }
 
-bool applyConfOnTypelibNumeric(Typelib::Value &value, const SimpleConfigValue& conf)
+bool applyConfOnTypelibNumeric(Typelib::Value &value, const SimpleConfigValue& conf, FlatLayout::Kind kind)
 {
-    const Typelib::Numeric *num = dynamic_cast<const Typelib::Numeric *>(&(value.getType()));
-    
-    switch(num->getNumericCategory())
+    switch(kind)
     {
-        case Typelib::Numeric::Float:
-            if(num->getSize() == sizeof(float))
-            {
-                return applyValue<float>(value, conf);
-            }
-            else
-            {
-                //double case
-                return applyValue<double>(value, conf);
-            }
-            break;
-        case Typelib::Numeric::SInt:
-            switch(num->getSize())
-            {
-                case sizeof(int8_t):
-                    return applyValue<int8_t>(value, conf);
-                    break;
-                case sizeof(int16_t):
-                    return applyValue<int16_t>(value, conf);
-                    break;
-                case sizeof(int32_t):
-                    return applyValue<int32_t>(value, conf);
-                    break;
-                case sizeof(int64_t):
-                    return applyValue<int64_t>(value, conf);
-                    break;
-                default:
-                    std::cout << "Error, got integer of unexpected size " << num->getSize() << std::endl;
-                    return false;
-                    break;
-            }
-            break;
-        case Typelib::Numeric::UInt:
+        case FlatLayout::FLOAT:
+            return applyValue<float>(value, conf);
+        case FlatLayout::DOUBLE:
+            return applyValue<double>(value, conf);
+        case FlatLayout::INT8:
+            return applyValue<int8_t>(value, conf);
+        case FlatLayout::INT16:
+            return applyValue<int16_t>(value, conf);
+        case FlatLayout::INT32:
+            return applyValue<int32_t>(value, conf);
+        case FlatLayout::INT64:
+            return applyValue<int64_t>(value, conf);
+        case FlatLayout::UINT8:
+        case FlatLayout::UINT16:
+        case FlatLayout::UINT32:
+        case FlatLayout::UINT64:
         {
             //HACK typelib encodes bools as unsigned integer. Brrrrr
             std::string lowerCase = conf.getValue();
             std::transform(lowerCase.begin(), lowerCase.end(), lowerCase.begin(), ::tolower);
             if(lowerCase == "true")
             {
-                return applyConfOnTypelibNumeric(value, SimpleConfigValue("1"));
+                return applyConfOnTypelibNumeric(value, SimpleConfigValue("1"), kind);
             }
             if(lowerCase == "false")
             {
-                return applyConfOnTypelibNumeric(value, SimpleConfigValue("0"));
+                return applyConfOnTypelibNumeric(value, SimpleConfigValue("0"), kind);
             }
             
-            switch(num->getSize())
+            switch(kind)
             {
-                case sizeof(uint8_t):
+                case FlatLayout::UINT8:
                     return applyValue<uint8_t>(value, conf);
-                    break;
-                case sizeof(uint16_t):
+                case FlatLayout::UINT16:
                     return applyValue<uint16_t>(value, conf);
-                    break;
-                case sizeof(uint32_t):
+                case FlatLayout::UINT32:
                     return applyValue<uint32_t>(value, conf);
-                    break;
-                case sizeof(uint64_t):
-                    return applyValue<uint64_t>(value, conf);
-                    break;
                 default:
-                    std::cout << "Error, got integer of unexpected size " << num->getSize() << std::endl;
-                    return false;
-                    break;
+                    return applyValue<uint64_t>(value, conf);
             }
         }
-            break;
-        case Typelib::Numeric::NumberOfValidCategories:
-            throw std::runtime_error("Internal Error: Got invalid Category");
-            break;
     }
     return true;
 }
 
+bool applyConfOnTypelibNumeric(Typelib::Value &value, const SimpleConfigValue& conf)
+{
+    const Typelib::Numeric *num = dynamic_cast<const Typelib::Numeric *>(&(value.getType()));
+    
+    FlatLayout::Kind kind;
+    if(!FlatLayout::getNumericKind(*num, kind))
+    {
+        std::cout << "Error, got numeric of unexpected size " << num->getSize() << std::endl;
+        return false;
+    }
+    return applyConfOnTypelibNumeric(value, conf, kind);
+}
+
 
 bool ConfigurationHelper::applyConfOnTyplibValue(Typelib::Value &value, const ConfigValue& conf)
 {
@@ -237,6 +221,21 @@ bool ConfigurationHelper::applyConfOnTyplibValue(Typelib::Value &value, const Co
                 return false;
             }
             
+            //Arrays of numerics are common (e.g. matrices), so the element
+            //type is only analyzed once for them
+            FlatLayout::Kind kind;
+            if(indirect.getCategory() == Typelib::Type::Numeric &&
+               FlatLayout::getNumericKind(static_cast<const Typelib::Numeric &>(indirect), kind))
+            {
+                for(size_t i = 0;i < arraySize; i++)
+                {
+                    Typelib::Value v( reinterpret_cast<uint8_t *>(value.getData()) + indirect.getSize() * i , indirect);
+                    if(!applyConfOnTypelibNumeric(v, dynamic_cast<const SimpleConfigValue &>(*(arrayConfig->getValues()[i])), kind))
+                        return false;
+                }
+                break;
+            }
+            
             for(size_t i = 0;i < arraySize; i++)
             {
                 size_t offset =  indirect.getSize() * i;
@@ -384,23 +383,56 @@ bool ConfigurationHelper::applyConfToProperty(RTT::TaskContext* context, const s
 }
 
 
-bool ConfigurationHelper::applyConfigValueOnDSB(RTT::base::DataSourceBase::shared_ptr dsb,
-        const RTT::types::TypeInfo* typeInfo, const libConfig::ConfigValue& value){
+const ConfigurationHelper::ResolvedType *ConfigurationHelper::resolveType(const RTT::types::TypeInfo* typeInfo)
+{
+    auto it = resolvedTypes.find(typeInfo);
+    if(it != resolvedTypes.end())
+        return &it->second;
 
-    orogen_transports::TypelibMarshallerBase *typelibTransport =
+    ResolvedType resolved;
+    resolved.typelibTransport =
             dynamic_cast<orogen_transports::TypelibMarshallerBase*>(
                     typeInfo->getProtocol(orogen_transports::TYPELIB_MARSHALLER_ID));
+    if(!resolved.typelibTransport)
+    {
+        std::cout << "Error, type " << typeInfo->getTypeName() << " has no typelib transport" << std::endl;
+        return nullptr;
+    }
+
+    resolved.type = resolved.typelibTransport->getRegistry().get(resolved.typelibTransport->getMarshallingType());
+    if(!resolved.type)
+    {
+        std::cout << "Error, type " << resolved.typelibTransport->getMarshallingType() << " is missing in the registry of its typelib transport" << std::endl;
+        return nullptr;
+    }
+    return &resolvedTypes.insert(std::make_pair(typeInfo, resolved)).first->second;
+}
+
+bool ConfigurationHelper::applyConfigValueOnDSB(RTT::base::DataSourceBase::shared_ptr dsb,
+        const RTT::types::TypeInfo* typeInfo, const libConfig::ConfigValue& value){
 
-    //TODO make faster by adding getType to transport
-    const Typelib::Type *type = typelibTransport->getRegistry().get(typelibTransport->getMarshallingType());
+    const ResolvedType *type = resolveType(typeInfo);
+    if(!type)
+        return false;
+
+    return applyConfigValueOnDSB(dsb, *type, value);
+}
+
+bool ConfigurationHelper::applyConfigValueOnDSB(RTT::base::DataSourceBase::shared_ptr dsb,
+        const ResolvedType& type, const libConfig::ConfigValue& value){
+
+    orogen_transports::TypelibMarshallerBase *typelibTransport = type.typelibTransport;
 
     orogen_transports::TypelibMarshallerBase::Handle *handle = typelibTransport->createSample();
 
     uint8_t *buffer = typelibTransport->getTypelibSample(handle);
 
-    Typelib::Value dest(buffer, *type);
+    Typelib::Value dest(buffer, *type.type);
 
-    if(typelibTransport->readDataSource(*dsb, handle))
+    //for plain types the typelib sample is the orocos sample. Note that an
+    //opaque is not plain even if its intermediate type is flat
+    const bool plain = typelibTransport->isPlainTypelibType();
+    if(typelibTransport->readDataSource(*dsb, handle) && !plain)
     {
         //we need to do this, in case that it is an opaque
         typelibTransport->refreshTypelibSample(handle);
@@ -412,7 +444,8 @@ bool ConfigurationHelper::applyConfigValueOnDSB(RTT::base::DataSourceBase::share
 
     //we modified the typlib samples, so we need to trigger the opaque
     //function here, to generate an updated orocos sample
-    typelibTransport->refreshOrocosSample(handle);
+    if(!plain)
+        typelibTransport->refreshOrocosSample(handle);
 
     //write value back
     typelibTransport->writeDataSource(*dsb, handle);
@@ -470,7 +503,9 @@ bool ConfigurationHelper::applyConfig(RTT::TaskContext* context, const std::vect
     RTT::OperationCaller< ::std::string() >  caller(op);
     std::string modelName = caller();
 
-    bool syncNeeded = PluginHelper::loadAllTypekitsForModel(modelName);
+    //configurations are applied through the typelib transport, which is
+    //loaded on demand if it is not loaded by default
+    bool syncNeeded = PluginHelper::loadAllTypekitsForModel(modelName, PluginHelper::getDefaultTransportsWith("typelib"));
     
     //this is not a prox, we don't need to sync
     if(!dynamic_cast<RTT::corba::TaskContextProxy *>(context))
@@ -661,11 +696,43 @@ YAML::Emitter &toYAML(YAML::Emitter &out, const Typelib::Compound &type, const T
     return out;
 }
 
+template <typename T>
+void arrayToYAML(YAML::Emitter &out, const void *data, size_t count){
+    const T *values = static_cast<const T *>(data);
+    for(size_t i = 0; i < count; i++)
+    {
+        out << values[i];
+    }
+}
+
 YAML::Emitter &toYAML(YAML::Emitter &out, const Typelib::Array &type, const Typelib::Value &value){
     out << YAML::Flow;
     out << YAML::BeginSeq;
 
     const Typelib::Type &indirect(type.getIndirection());
+
+    //Arrays of numerics are written without looking at the type of each element
+    FlatLayout::Kind kind;
+    if(indirect.getCategory() == Typelib::Type::Numeric &&
+       FlatLayout::getNumericKind(static_cast<const Typelib::Numeric &>(indirect), kind))
+    {
+        switch(kind)
+        {
+        case FlatLayout::FLOAT: arrayToYAML<float>(out, value.getData(), type.getDimension()); break;
+        case FlatLayout::DOUBLE: arrayToYAML<double>(out, value.getData(), type.getDimension()); break;
+        case FlatLayout::INT8: arrayToYAML<int8_t>(out, value.getData(), type.getDimension()); break;
+        case FlatLayout::INT16: arrayToYAML<int16_t>(out, value.getData(), type.getDimension()); break;
+        case FlatLayout::INT32: arrayToYAML<int32_t>(out, value.getData(), type.getDimension()); break;
+        case FlatLayout::INT64: arrayToYAML<int64_t>(out, value.getData(), type.getDimension()); break;
+        case FlatLayout::UINT8: arrayToYAML<uint8_t>(out, value.getData(), type.getDimension()); break;
+        case FlatLayout::UINT16: arrayToYAML<uint16_t>(out, value.getData(), type.getDimension()); break;
+        case FlatLayout::UINT32: arrayToYAML<uint32_t>(out, value.getData(), type.getDimension()); break;
+        case FlatLayout::UINT64: arrayToYAML<uint64_t>(out, value.getData(), type.getDimension()); break;
+        }
+        out << YAML::EndSeq;
+        return out;
+    }
+
     for(size_t i = 0; i < type.getDimension(); i++)
     {
         Typelib::Value arrayV(static_cast<uint8_t *>(value.getData()) + i * indirect.getSize(), indirect);
@@ -6,6 +6,7 @@
 #include <typelib/typemodel.hh>
 #include <typelib/value.hh>
 #include <lib_config/YAMLConfiguration.hpp>
+#include <unordered_map>
 
 
 //forwards:
@@ -14,6 +15,10 @@ namespace Typelib{
     class Value;
 }
 
+namespace orogen_transports{
+    class TypelibMarshallerBase;
+}
+
 YAML::Emitter &operator <<(YAML::Emitter &out, const Typelib::Value &value);
 
 namespace orocos_cpp
@@ -48,6 +53,29 @@ public:
      */
     bool applyConfigValueOnDSB(RTT::base::DataSourceBase::shared_ptr dsb,
             const RTT::types::TypeInfo* typeInfo, const libConfig::ConfigValue& value);
+
+    /**
+     * @brief Typelib view of an RTT type, see resolveType
+     */
+    struct ResolvedType
+    {
+        orogen_transports::TypelibMarshallerBase *typelibTransport;
+        const Typelib::Type *type;
+    };
+
+    /**
+     * @brief Looks up the typelib transport and the Typelib type of \p typeInfo.
+     * The result is kept, so repeated calls for the same type do not search
+     * the typelib registry by name again.
+     * @return nullptr if the type has no typelib transport
+     */
+    const ResolvedType *resolveType(const RTT::types::TypeInfo* typeInfo);
+
+    /**
+     * @brief Like applyConfigValueOnDSB(dsb, typeInfo, value), with a type resolved by resolveType
+     */
+    bool applyConfigValueOnDSB(RTT::base::DataSourceBase::shared_ptr dsb,
+            const ResolvedType& type, const libConfig::ConfigValue& value);
     bool applyConfOnTyplibValue(Typelib::Value &value, const libConfig::ConfigValue& conf);
     /**
      * @brief Convinience functions to load data samples from YAML
@@ -76,6 +104,7 @@ public:
 
 private:
     std::map<std::string, libConfig::Configuration> overrides;
+    std::unordered_map<const RTT::types::TypeInfo*, ResolvedType> resolvedTypes;
 };
 
 
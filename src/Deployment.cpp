@@ -34,7 +34,37 @@ Deployment::Deployment(const std::string &cmp1, const std::string &as, bool load
     std::string defaultDeploymentName = "orogen_default_" + moduleName + "__" + taskModelName;
     
     deploymentName = defaultDeploymentName;
+    std::string modelTaskName = defaultDeploymentName;
     if(load_pkg_config){
+        PkgConfigRegistryPtr pkgreg = PkgConfigRegistry::get();
+        if(!pkgreg->getDeployment(defaultDeploymentName)){
+            //No default deployment installed. Use a loaded deployment that
+            //provides the model instead, but only if it is the only one, and
+            //it hosts no other tasks that would be started with it
+            std::vector<DeployedTask> candidates = pkgreg->getDeployedTasksOfModel(cmp1);
+            std::vector<DeployedTask> dedicated;
+            std::string candidateNames;
+            for(const DeployedTask &candidate : candidates)
+            {
+                candidateNames += (candidateNames.empty() ? "" : ", ") + candidate.deployment + " (" + candidate.task + ")";
+                size_t nOtherTasks = 0;
+                for(const DeployedTask &task : pkgreg->getDeployedTasks(candidate.deployment))
+                {
+                    if(task.task != candidate.task && task.model != "logger::Logger")
+                        nOtherTasks++;
+                }
+                if(nOtherTasks == 0)
+                    dedicated.push_back(candidate);
+            }
+            if(dedicated.size() != 1)
+            {
+                throw std::runtime_error("Deployment::Error, could not find pkgConfig file for deployment " + defaultDeploymentName +
+                                         (candidates.empty() ? std::string() : ", no unique deployment hosts only " + cmp1 + ", candidates are: " + candidateNames));
+            }
+            deploymentName = dedicated.front().deployment;
+            modelTaskName = dedicated.front().task;
+            LOG_INFO_S << "No default deployment for " << cmp1 << " found, using task " << modelTaskName << " of deployment " << deploymentName;
+        }
         try {
             loadPkgConfigFile(deploymentName);
         }
@@ -51,8 +81,10 @@ Deployment::Deployment(const std::string &cmp1, const std::string &as, bool load
     
     if(!taskName.empty())
     {
-        renameTask(defaultDeploymentName, taskName);
-        renameTask(defaultDeploymentName  + "_Logger", taskName + "_Logger");
+        renameTask(modelTaskName, taskName);
+        //Only default deployments have a logger per task
+        if(deploymentName == defaultDeploymentName)
+            renameTask(defaultDeploymentName  + "_Logger", taskName + "_Logger");
     }
 }
 
@@ -99,19 +131,19 @@ bool Deployment::checkExecutable(const std::string& name)
 bool Deployment::loadPkgConfigFile(const std::string& deploymentName)
 {
     PkgConfigRegistryPtr pkgreg = PkgConfigRegistry::get();
-    PkgConfig pkg;
+    PkgConfigConstPtr pkg = pkgreg->getDeployment(deploymentName);
 
-    if(!pkgreg->getDeployment(deploymentName, pkg))
+    if(!pkg)
         throw std::runtime_error("PkgConfig file for deployment " + deploymentName + " was not loaded." );
 
     //Extract required information from PkgConfig
     std::string typekitsString, deployedTasksString;
-    if(!pkg.getVariable("typekits", typekitsString)){
+    if(!pkg->getVariable("typekits", typekitsString)){
         throw(std::runtime_error("PkgConfig file for deployment "+deploymentName+" does not describe required typekits."));
     }
     std::vector<std::string> typekits = PkgConfigHelper::vectorizeTokenSeparatedString(typekitsString, " ");
 
-    if(!pkg.getVariable("deployed_tasks", deployedTasksString)){
+    if(!pkg->getVariable("deployed_tasks", deployedTasksString)){
         throw(std::runtime_error("PkgConfig file for deployment "+deploymentName+" does not describe required typekits."));
     }
     std::vector<std::string> deployedTasks = PkgConfigHelper::vectorizeTokenSeparatedString(deployedTasksString, ",");
@@ -0,0 +1,41 @@
+#include "FlatLayout.hpp"
+#include <cstdint>
+
+namespace orocos_cpp
+{
+
+bool FlatLayout::getNumericKind(const Typelib::Numeric &type, Kind &kind)
+{
+    switch(type.getNumericCategory())
+    {
+        case Typelib::Numeric::Float:
+            switch(type.getSize())
+            {
+                case sizeof(float): kind = FLOAT; return true;
+                case sizeof(double): kind = DOUBLE; return true;
+            }
+            return false;
+        case Typelib::Numeric::SInt:
+            switch(type.getSize())
+            {
+                case sizeof(int8_t): kind = INT8; return true;
+                case sizeof(int16_t): kind = INT16; return true;
+                case sizeof(int32_t): kind = INT32; return true;
+                case sizeof(int64_t): kind = INT64; return true;
+            }
+            return false;
+        case Typelib::Numeric::UInt:
+            switch(type.getSize())
+            {
+                case sizeof(uint8_t): kind = UINT8; return true;
+                case sizeof(uint16_t): kind = UINT16; return true;
+                case sizeof(uint32_t): kind = UINT32; return true;
+                case sizeof(uint64_t): kind = UINT64; return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+}
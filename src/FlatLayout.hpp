@@ -0,0 +1,24 @@
+#pragma once
+#include <typelib/typemodel.hh>
+
+namespace orocos_cpp
+{
+
+/*!
+ * \brief Memory layout of Typelib numerics
+ *
+ * Arrays of numerics (e.g. matrices) are accessed as plain C arrays of the
+ * element's Kind, instead of analyzing the type of each element.
+ */
+class FlatLayout
+{
+public:
+    enum Kind { INT8, INT16, INT32, INT64, UINT8, UINT16, UINT32, UINT64, FLOAT, DOUBLE };
+
+    /**
+     * @returns false if \p type is not a numeric of a supported size
+     */
+    static bool getNumericKind(const Typelib::Numeric& type, Kind& kind);
+};
+
+}
@@ -36,20 +36,22 @@ LoggerProxyInitializer::LoggerProxyInitializer(std::string location, bool is_ior
 
 void LoggerProxyInitializer::initTypes()
 {
-    //dynamically load the base and logger typekits
-    if(!PluginHelper::loadTypekitAndTransports("std"))
+    //dynamically load the base and logger typekits. The proxy connects
+    //through corba, so its transport is needed whatever the defaults are
+    const std::vector<std::string> transports = PluginHelper::getDefaultTransportsWith("corba");
+    if(!PluginHelper::loadTypekitAndTransports("std", transports))
     {
         std::cout << "LoggerHelper : Error, could not load std typekit, is it not installed ?" << std::endl;
         throw std::runtime_error("LoggerHelper : Error, could not load std typekit, is it not installed ?");
     }
 
-    if(!PluginHelper::loadTypekitAndTransports("base"))
+    if(!PluginHelper::loadTypekitAndTransports("base", transports))
     {
         std::cout << "LoggerHelper : Error, could not load base typekit, is it not installed ?" << std::endl;
         throw std::runtime_error("LoggerHelper : Error, could not load base typekit, is it not installed ?");
     }
    
-    if(!PluginHelper::loadTypekitAndTransports("logger"))
+    if(!PluginHelper::loadTypekitAndTransports("logger", transports))
     {
         std::cout << "LoggerHelper : Error, could not load logger typekit, is it not installed ?" << std::endl;
         throw std::runtime_error("LoggerHelper : Error, could not load logger typekit, is it not installed ?");
@@ -20,6 +20,39 @@ LoggingHelper::LoggingHelper() : DEFAULT_LOG_BUFFER_SIZE(100)
 
 }
 
+/**
+ * Loads rtt-types and the typekits of all given deployments, including
+ * the typekits they require, as one plan in dependency order. The ports
+ * are logged through corba, so its transport is loaded even if it is not
+ * a default transport.
+ * */
+static void loadNeededTypekits(const std::vector<const Deployment *> &depls)
+{
+    std::vector<std::string> neededTks;
+    neededTks.push_back("rtt-types");
+    for(const Deployment *dpl: depls)
+    {
+        const std::vector<std::string> &tks(dpl->getNeededTypekits());
+        neededTks.insert(neededTks.end(), tks.begin(), tks.end());
+    }
+
+    PluginHelper::TypekitLoadPlan plan = PluginHelper::getTypekitLoadPlan(neededTks, PluginHelper::getDefaultTransportsWith("corba"));
+    for(const std::string &tk: plan.typekits)
+    {
+        std::cout << "Warning, we are missing the typekit " << tk << " loading it " << std::endl;
+    }
+
+    PluginHelper::loadTypekits(plan);
+
+    for(const std::string &tk: plan.typekits)
+    {
+        if(!RTT::types::TypekitRepository::hasTypekit(tk))
+        {
+            std::cout << "Load failed for typekit " << tk << std::endl;
+        }
+    }
+}
+
 bool LoggingHelper::logTasks()
 {
     return logTasks(std::map<std::string, bool>(), true);
@@ -34,27 +67,10 @@ bool LoggingHelper::logTasks(const std::map<std::string, bool> &loggingEnabledTa
     
     RTT::plugin::PluginLoader loader;
 
-    if(!RTT::types::TypekitRepository::hasTypekit("rtt-types"))
-        PluginHelper::loadTypekitAndTransports("rtt-types");
+    loadNeededTypekits(depls);
     
     for(const Deployment *dpl: depls)
     {
-        //load all needed typekits
-        for(const std::string &tk: dpl->getNeededTypekits())
-        {
-            if(!RTT::types::TypekitRepository::hasTypekit(tk))
-            {
-                
-                std::cout << "Warning, we are missing the typekit " << tk << " loading it " << std::endl;
-                PluginHelper::loadTypekitAndTransports(tk);
-            }
-
-            if(!RTT::types::TypekitRepository::hasTypekit(tk))
-            {
-                std::cout << "Load failed" << std::endl;
-            }
-        }
-        
         for(const std::string &task: dpl->getTaskNames())
         {
             //don't log the logger :-)
@@ -95,27 +111,10 @@ bool LoggingHelper::logTasks(const std::vector< std::string >& excludeList)
     
     RTT::plugin::PluginLoader loader;
 
-    if(!RTT::types::TypekitRepository::hasTypekit("rtt-types"))
-        PluginHelper::loadTypekitAndTransports("rtt-types");
+    loadNeededTypekits(depls);
     
     for(const Deployment *dpl: depls)
     {
-        //load all needed typekits
-        for(const std::string &tk: dpl->getNeededTypekits())
-        {
-            if(!RTT::types::TypekitRepository::hasTypekit(tk))
-            {
-                
-                std::cout << "Warning, we are missing the typekit " << tk << " loading it " << std::endl;
-                PluginHelper::loadTypekitAndTransports(tk);
-            }
-
-            if(!RTT::types::TypekitRepository::hasTypekit(tk))
-            {
-                std::cout << "Load failed" << std::endl;
-            }
-        }
-        
         for(const std::string &task: dpl->getTaskNames())
         {
             //don't log the logger :-)
@@ -157,17 +156,14 @@ bool LoggingHelper::logAllPorts(RTT::TaskContext* givenContext, const std::strin
 
     if(loadTypekits)
     {
-        PluginHelper::loadTypekitAndTransports("rtt-types");
-
         RTT::OperationCaller<std::string ()> getModelName(context->getOperation("getModelName"));
         std::string modelName = getModelName();
         std::string componentName = modelName.substr(0, modelName.find_first_of(':'));
         
         std::vector<std::string> neededTks = PluginHelper::getNeededTypekits(componentName);
-        for(const std::string &tk: neededTks)
-        {
-            PluginHelper::loadTypekitAndTransports(tk);
-        }
+        neededTks.insert(neededTks.begin(), "rtt-types");
+        PluginHelper::TypekitLoadPlan plan = PluginHelper::getTypekitLoadPlan(neededTks, PluginHelper::getDefaultTransportsWith("corba"));
+        PluginHelper::loadTypekits(plan);
         
         //ugly, but only way I see to ensure that all ports get created
         context = RTT::corba::TaskContextProxy::Create(taskName, false);
@@ -8,12 +8,22 @@ public:
     OrocosCppConfig() :
         package_initialization_whitelist(std::vector<std::string>()),
         load_all_packages(false),
+        package_registry_cache_file(""),
+        package_scan_workers(1),
+        watch_package_changes(false),
         init_bundle(false),
         create_log_folder(false),
         oro_log_file_path(""),
         load_task_configs(false),
         init_type_registry(false),
+        type_registry_cache_file(""),
+        type_registry_load_workers(1),
+        type_registry_lazy_loading(false),
         load_typekits(true),
+        typekit_prefetch_workers(1),
+        typekit_transports({"corba", "mqueue", "typelib"}),
+        typekit_manifest_file(""),
+        typekit_bundle_file(""),
         corba_host(""),
         init_corba(true),
         max_message_size(-1)
@@ -30,6 +40,27 @@ public:
     //! and all isntalled pacakges will be loaded on start-up.
     bool load_all_packages;
 
+    //! File in which the result of scanning all installed packages is cached.
+    //! Only evaluated if \var load_all_packages is \value true. If empty, no
+    //! cache is used. The cache is rebuilt automatically when the
+    //! PKG_CONFIG_PATH, the modification times of its directories or
+    //! OROCOS_TARGET change. Adding, removing or renaming a PkgConfig file
+    //! updates the modification time of its directory, rewriting a file in
+    //! place does not.
+    std::string package_registry_cache_file;
+
+    //! Number of threads used to scan the PKG_CONFIG_PATH if
+    //! \var load_all_packages is \value true. Parallel scanning pays off on
+    //! network file systems, where each file access has a high latency.
+    //! 0 uses one thread per core.
+    unsigned package_scan_workers;
+
+    //! Should the PKG_CONFIG_PATH be watched for changed packages?
+    //! If set to \value true, packages that are installed, rebuilt or removed
+    //! while the process runs are picked up by the package registry without
+    //! rescanning all installed packages.
+    bool watch_package_changes;
+
     //! should the currently selected bundle be initialized?
     //! If set to \value true, the ROCK_BUNDLE and ROCK_BUNDLE_PATH evironment
     //! variables are evaluated to determine selected bundle that should be
@@ -59,12 +90,66 @@ public:
     //! values and therefore need to parse the typekits tlb files.
     bool init_type_registry;
 
+    //! File in which the loaded type registry is cached.
+    //! Only evaluated if \var init_type_registry is \value true. If empty,
+    //! no cache is used. The cache is rebuilt automatically when typekits are
+    //! added, removed or rebuilt.
+    std::string type_registry_cache_file;
+
+    //! Number of threads used to parse the tlb files of the typekits if
+    //! \var init_type_registry is \value true. 0 uses one thread per core.
+    unsigned type_registry_load_workers;
+
+    //! Should typekits be loaded into the type registry on demand?
+    //! Only evaluated if \var init_type_registry is \value true. If set to
+    //! \value true, only the typelist files of the typekits are read at
+    //! initialization, and the tlb file of a typekit is parsed when one of
+    //! its types is requested first (see TypeRegistry::enableLazyLoading).
+    //! \var type_registry_cache_file and \var type_registry_load_workers
+    //! are not used then.
+    bool type_registry_lazy_loading;
+
     //! Should typekits be initialized
     //! If set to \value true, the Typekits for the
     //! packages listed in \var module_initialization_whitelist will be
     //! loaded.
     bool load_typekits;
 
+    //! Number of threads that read the typekit and transport libraries into
+    //! the page cache while \var load_typekits loads them one after another.
+    //! 0 uses one thread per core. More threads pay off on network file
+    //! systems and on cold starts from disk.
+    unsigned typekit_prefetch_workers;
+
+    //! Transports that are loaded together with each typekit, a subset of
+    //! corba, mqueue and typelib. Every transport costs a shared library
+    //! per typekit. Transports that are not listed are loaded on demand,
+    //! typelib by ConfigurationHelper::applyConfig, and corba by
+    //! OrocosCpp::getTaskContext and LoggingHelper. OrocosCpp::initialize
+    //! fails for other transports. See PluginHelper::setDefaultTransports.
+    std::vector<std::string> typekit_transports;
+
+    //! File in which the libraries loaded by \var load_typekits are
+    //! recorded, in load order. If it is valid on the next start, the
+    //! libraries are loaded directly from it, before and without resolving
+    //! their paths through the PkgConfig files. If any library or its
+    //! PkgConfig file changed, a directory of the PKG_CONFIG_PATH was
+    //! modified, or other packages or transports are requested, the
+    //! typekits are loaded the normal way and the manifest is rewritten.
+    //! If empty, no manifest is used. See TypekitManifest.
+    std::string typekit_manifest_file;
+
+    //! Typekit bundle that is loaded before the other typekits of
+    //! \var load_typekits. A bundle only depends on the typekit libraries,
+    //! which are still relocated and registered one by one, see
+    //! PluginHelper::loadTypekitBundle. It is skipped if any of its
+    //! libraries or PkgConfig files changed since it was built. Typekits
+    //! that are not part of the bundle are loaded the normal way. If empty,
+    //! no bundle is used. Bundles are built with
+    //! PluginHelper::buildTypekitBundle, e.g. for the typekits needed by a
+    //! set of deployments.
+    std::string typekit_bundle_file;
+
     //! Hostname or IP of the CORBA Nameservice to connect to
     //! If an empty string is given, the locally running CORBA nameservice
     //! will be used.
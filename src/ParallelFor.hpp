@@ -0,0 +1,55 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace orocos_cpp
+{
+
+//! std::thread that is joined when it goes out of scope, so an exception on
+//! the owning thread does not end in std::terminate
+class ScopedThread
+{
+public:
+    template<typename F>
+    explicit ScopedThread(F&& f) : thread(std::forward<F>(f)) {}
+    ScopedThread(ScopedThread&&) = default;
+    ~ScopedThread()
+    {
+        if(thread.joinable()){
+            thread.join();
+        }
+    }
+    void join()
+    {
+        thread.join();
+    }
+
+private:
+    std::thread thread;
+};
+
+//! Runs \p work(i) for all i in [0, n) on \p nWorkers threads (including the
+//! calling thread). 0 uses one thread per core.
+template<typename F>
+void parallel_for(size_t n, unsigned nWorkers, const F& work)
+{
+    if(nWorkers == 0){
+        nWorkers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::atomic<size_t> next(0);
+    auto worker = [&](){
+        for(size_t i = next++; i < n; i = next++){
+            work(i);
+        }
+    };
+    std::vector<ScopedThread> threads;
+    for(unsigned i=1; i<nWorkers && i<n; i++){
+        threads.emplace_back(worker);
+    }
+    worker();
+}
+
+}
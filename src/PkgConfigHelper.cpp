@@ -3,7 +3,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/tokenizer.hpp>
 #include <fstream>
-#include <regex>
+#include <cstring>
 #include <boost/algorithm/string.hpp>
 #include <iostream>
 #include <base-logging/Logging.hpp>
@@ -55,79 +55,129 @@ std::string find_file(const std::string filename, const std::vector<std::string>
 
 
 
+//! Characters that may be used in the name of a variable or property
+static inline bool isNameChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '-';
+}
+
+//! Characters that may be used in the name of a variable reference (e.g. ${varname})
+static inline bool isWordChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+static inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+//! Assigns the range [\p begin, \p end) with leading and trailing whitespaces removed to \p out
+static inline void assignTrimmed(const char* begin, const char* end, std::string& out)
+{
+    while(begin != end && isSpace(*begin))
+        ++begin;
+    while(end != begin && isSpace(*(end-1)))
+        --end;
+    out.assign(begin, end);
+}
+
+//! Resolution state of a variable while substituting references
+enum VariableState { VAR_UNRESOLVED, VAR_RESOLVING, VAR_RESOLVED, VAR_FAILED };
+typedef std::map<std::string, std::string> VariableMap;
+typedef std::map<std::string, VariableState> VariableStates;
+
+static VariableState resolveVariable(VariableMap::iterator var, VariableMap& variables, VariableStates& states);
+
 //!
-//! \brief substitudes all occurences of a varibale in \p line by it's substitudes given in \p variables
+//! \brief substitudes all occurences of a varibale in \p line by its value given in \p variables
+//! Referenced variables are resolved before they are substituted (see resolveVariable), so
+//! substituted values do not have to be scanned again.
 //! \param line : The input line that can contain variables. A variable is identified by beeing enclosed by 2${}". e.g. ${varname})
 //! \param variables : A map containing <varname, value used for substitution>-tuples
-//! \param substituded : Substituded version of \p line will be stored here
+//! \param states : Resolution state of the variables in \p variables
+//! \param substituded : Substituded version of \p line will be stored here. May be \p line itself.
 //! \return true if all varibales where successfully substituded. False if a varibale could not be resolved.
 //!
-bool substitude(const std::string& line, const std::map<std::string, std::string>& variables, std::string& substituded)
+static bool substitude(const std::string& line, VariableMap& variables, VariableStates& states, std::string& substituded)
 {
-    std::regex e{R"(.*\$\{(\w*)\}.*)"};
-    std::smatch sm;
-    std::string new_line = line;
+    std::string new_line;
+    new_line.reserve(line.size());
     bool ok = true;
-    while(std::regex_match(new_line, sm, e)){
-        std::string varname = sm[1];
-        std::string varstr = "${"+varname+"}";
-        try{
-            std::string val = variables.at(varname);
-            size_t pos = new_line.find(varstr);
-            new_line.replace(pos, varstr.size(), val);
-        }catch(std::out_of_range& ex){
+    size_t pos = 0;
+    size_t copied = 0;
+    while((pos = line.find("${", pos)) != std::string::npos){
+        size_t name_end = pos + 2;
+        while(name_end < line.size() && isWordChar(line[name_end]))
+            ++name_end;
+        if(name_end >= line.size() || line[name_end] != '}'){
+            //Not a variable reference, e.g. '${foo bar}'
+            pos += 2;
+            continue;
+        }
+
+        const size_t ref_begin = pos;
+        pos = name_end + 1;
+        const std::string varname = line.substr(ref_begin + 2, name_end - ref_begin - 2);
+        VariableMap::iterator it = variables.find(varname);
+        if(it == variables.end()){
             LOG_WARN_S << "Could not substitude varibale " << varname;
-            ok=false;
+            ok = false;
+            continue;
         }
+        VariableState state = resolveVariable(it, variables, states);
+        if(state == VAR_RESOLVING){
+            //Cyclic reference, keep it
+            ok = false;
+            continue;
+        }
+        ok &= state == VAR_RESOLVED;
+        new_line.append(line, copied, ref_begin - copied);
+        new_line += it->second;
+        copied = pos;
     }
-    substituded = new_line;
+    new_line.append(line, copied, std::string::npos);
+    substituded.swap(new_line);
     return ok;
 }
 
 //!
-//! \brief Identifies if the given \p line is a PKGConfig comment
-//! \param line
-//! \return true if \p line is a comment. false otherwise.
+//! \brief Substitudes the references in the value of \p var, after resolving the referenced variables
+//! Each variable is resolved only once, so resolving all variables of a file takes linear time
+//! regardless of the order in which they are defined. References that form a cycle are not substituted.
+//! \return VAR_RESOLVED, VAR_FAILED if a reference could not be resolved, or VAR_RESOLVING if
+//!         \p var is currently being resolved, i.e. it refers to itself
 //!
-void truncateComment(std::string& line)
+static VariableState resolveVariable(VariableMap::iterator var, VariableMap& variables, VariableStates& states)
 {
-    //Is comment if first character is '#'
-    size_t pos = line.find('#');
-    if(pos == std::string::npos)
-        return;
+    VariableState& state = states[var->first];
+    if(state == VAR_RESOLVING){
+        LOG_WARN_S << "Variable " << var->first << " refers to itself";
+        return state;
+    }
+    if(state != VAR_UNRESOLVED)
+        return state;
 
-    line = line.substr(0, pos);
+    state = VAR_RESOLVING;
+    bool ok = var->second.find("${") == std::string::npos || substitude(var->second, variables, states, var->second);
+    state = ok ? VAR_RESOLVED : VAR_FAILED;
+    return state;
 }
 
+//! Possible results of parseLine
+enum LineKind { LINE_EMPTY, LINE_VARIABLE, LINE_PROPERTY, LINE_INVALID };
+
 //!
-//! \brief Identifies if the given \p line is a variable assignment
+//! \brief Classifies a single line of a PkgConfig file
+//! Comments (starting with '#') are stripped before classification.
 //! Varibales in PKGConfig can have arbitrary names. They are assigned by "varname=value".
 //! Example:
 //!     prefix=/my/prefix
 //!     exec_prefix=${prefix}
 //!     libdir=${prefix}/lib/orocos/types
-//! \param line
-//! \return true if \p line is a varibale assignment. false otherwise.
-//!
-bool parseVariable(const std::string& line, std::string& var_name, std::string& value)
-{
-    //Start of line, followed by a word, followed by a '=' sign, NO whitespace
-    std::regex e(R"(^([\w\d\.-]+)=(.*))");
-    std::smatch sm;
-    if(std::regex_match(line, sm, e)){
-        assert(sm.size() == 3);
-        var_name = sm[1];
-        value = sm[2];
-        boost::trim(var_name);
-        boost::trim(value);
-        return true;
-    }
-    return false;
-}
-
-//!
-//! \brief Identifies if the given \p line is a property assignment
-//! //! In PKGConfig there exists a defined set of properties to describe a software module for compiling and linking. They are assigned by "propname: value".
+//! In PKGConfig there exists a defined set of properties to describe a software module for compiling and linking. They are assigned by "propname: value".
 //! Example:
 //!    Name: testTypekit
 //!    Version: 0.0
@@ -135,23 +185,35 @@ bool parseVariable(const std::string& line, std::string& var_name, std::string&
 //!    Description: test types support for the Orocos type system
 //!    Libs: -L${libdir} -ltest-typekit-gnulinux
 //!    Cflags: -I${includedir} -I${includedir}/test/types "-DOROCOS_TARGET=gnulinux"
-//! \param line
-//! \return true if \p line is a comment. false otherwise.
+//! \param begin : Start of the line
+//! \param end : End of the line, excluding the line break
+//! \param name : Name of the variable or property will be stored here
+//! \param value : Assigned value will be stored here
+//! \return LINE_VARIABLE, LINE_PROPERTY, LINE_EMPTY or LINE_INVALID if the line could not be parsed
 //!
-bool parseProperty(const std::string& line, std::string& prop_name, std::string& value)
+LineKind parseLine(const char* begin, const char*& end, std::string& name, std::string& value)
 {
-    //Start of line, followed by a sequence of characters, followed by a ':' sign, followed by a whitespace
-    std::regex e(R"(^([\w\d\.-]+):(.*))");
-    std::smatch sm;
-    if(std::regex_match(line, sm, e)){
-        assert(sm.size() == 3);
-        prop_name = sm[1];
-        value = sm[2];
-        boost::trim(prop_name);
-        boost::trim(value);
-        return true;
+    //Is comment if character is '#'
+    const char* comment = static_cast<const char*>(memchr(begin, '#', end - begin));
+    if(comment)
+        end = comment;
+
+    //Start of line, followed by a word, followed by a '=' or ':' sign, NO whitespace
+    const char* c = begin;
+    while(c != end && isNameChar(*c))
+        ++c;
+    if(c != begin && c != end && (*c == '=' || *c == ':')){
+        name.assign(begin, c);
+        assignTrimmed(c + 1, end, value);
+        return *c == '=' ? LINE_VARIABLE : LINE_PROPERTY;
     }
-    return false;
+
+    //Not a comment, property or variable.. check if empty (only whitespaces)
+    for(c = begin; c != end; ++c){
+        if(*c != ' ')
+            return LINE_INVALID;
+    }
+    return LINE_EMPTY;
 }
 
 bool PkgConfigHelper::parsePkgConfig(const std::string& filePathOrName, std::map<std::string,std::string>& variables, std::map<std::string,std::string>& properties, bool isFilePath)
@@ -165,51 +227,66 @@ bool PkgConfigHelper::parsePkgConfig(const std::string& filePathOrName, std::map
         filepath = filePathOrName;
     }
 
-    std::ifstream fileStream(filepath);
+    std::ifstream fileStream(filepath, std::ios::in | std::ios::binary);
     if(!fileStream.is_open()){
         LOG_INFO_S << "Could not open file " << filepath;
         return false;
     }
 
+    //Read the whole file at once and scan it in a single pass
+    std::string buffer;
+    fileStream.seekg(0, std::ios::end);
+    std::streamoff size = fileStream.tellg();
+    if(size > 0){
+        buffer.resize(size);
+        fileStream.seekg(0, std::ios::beg);
+        fileStream.read(&buffer[0], size);
+        buffer.resize(fileStream.gcount());
+    }
+
     bool all_ok=true;
-    while(!fileStream.eof())
+    std::string name, value;
+    const char* cur = buffer.data();
+    const char* const buffer_end = cur + buffer.size();
+    while(cur != buffer_end)
     {
-        std::string curLine;
-        std::getline(fileStream, curLine);
-        truncateComment(curLine);
+        const char* line_end = static_cast<const char*>(memchr(cur, '\n', buffer_end - cur));
+        const char* next = line_end ? line_end + 1 : buffer_end;
+        if(!line_end)
+            line_end = buffer_end;
+        //Tolerate DOS line endings
+        if(line_end != cur && *(line_end-1) == '\r')
+            --line_end;
 
-        std::string name, value;
-        if(parseVariable(curLine, name, value)){
+        switch(parseLine(cur, line_end, name, value)){
+        case LINE_VARIABLE:
             variables[name] = value;
-            continue;
-        }
-        if(parseProperty(curLine, name, value)){
+            break;
+        case LINE_PROPERTY:
             properties[name] = value;
-            continue;
-        }
-
-        //Not a comment, property or variable.. check if empty (only whitespaces and print warning otherwise)
-        std::string curLine2 = curLine;
-        std::string::iterator end_pos = std::remove(curLine2.begin(), curLine2.end(), ' '); //Removes all whitespaces
-        curLine2.erase(end_pos, curLine2.end());
-
-        //Deletes all whitespaces
-        if(!curLine2.empty()){
-            LOG_WARN_S << "Could not parse line " << curLine << " from PkgConfig-file " << filepath;
+            break;
+        case LINE_INVALID:
+            LOG_WARN_S << "Could not parse line " << std::string(cur, line_end) << " from PkgConfig-file " << filepath;
             all_ok = false;
+            break;
+        case LINE_EMPTY:
+            break;
         }
+        cur = next;
     }
 
     //Substitude field values with values from variables
-    for(std::pair<const std::string, std::string>& var : variables){
-        bool st = substitude(var.second, variables, var.second);
-        if(!st){
-            LOG_ERROR_S << "Could not substitude value '" << var.second << "' of variable " << var.first << " from PkgConfig-file " << filepath;
+    VariableStates states;
+    for(VariableMap::iterator var = variables.begin(); var != variables.end(); ++var){
+        if(resolveVariable(var, variables, states) != VAR_RESOLVED){
+            LOG_ERROR_S << "Could not substitude value '" << var->second << "' of variable " << var->first << " from PkgConfig-file " << filepath;
             all_ok = false;
         }
     }
     for(std::pair<const std::string, std::string>& prop : properties){
-        bool st = substitude(prop.second, variables, prop.second);
+        if(prop.second.find("${") == std::string::npos)
+            continue;
+        bool st = substitude(prop.second, variables, states, prop.second);
         if(!st){
             LOG_ERROR_S << "Could not substitude value " << prop.second << "' of property "<< prop.first << " from PkgConfig-file " << filepath;
             all_ok = false;
@@ -1,6 +1,22 @@
 #include "PkgConfigRegistry.hpp"
 #include "PkgConfigHelper.hpp"
+#include "ParallelFor.hpp"
 #include <regex>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <unordered_set>
+#include <set>
+#include <algorithm>
+#include <chrono>
 #include <boost/filesystem.hpp>
 #include <base-logging/Logging.hpp>
 
@@ -13,45 +29,164 @@ void extract_keys(const std::map<std::string,T>& m, std::vector<std::string>& re
     }
 }
 
+//Helpers for the binary cache format. Strings are stored length prefixed.
+static void write_uint32(std::ostream& os, uint32_t v)
+{
+    os.write(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+static bool read_uint32(std::istream& is, uint32_t& v)
+{
+    return bool(is.read(reinterpret_cast<char*>(&v), sizeof(v)));
+}
+
+static void write_string(std::ostream& os, const std::string& s)
+{
+    write_uint32(os, s.size());
+    os.write(s.data(), s.size());
+}
+
+static bool read_string(std::istream& is, std::string& s)
+{
+    uint32_t size;
+    if(!read_uint32(is, size))
+        return false;
+    s.resize(size);
+    return size == 0 || bool(is.read(&s[0], size));
+}
+
+//Returns the process wide instance of the string \p s
+static const std::string* intern(const std::string& s)
+{
+    //Elements of an unordered_set are never moved, so pointers to them stay valid
+    static std::unordered_set<std::string> pool;
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    return &*pool.insert(s).first;
+}
+
+typedef std::pair<const std::string*, std::string> Field;
+
+static bool field_less(const Field& field, const std::string& name)
+{
+    return *field.first < name;
+}
+
+void orocos_cpp::PkgConfig::assignFields(Fields &fields, const std::map<std::string, std::string> &values)
+{
+    //std::map is sorted by key already
+    fields.clear();
+    fields.reserve(values.size());
+    for(const auto& kv : values){
+        fields.push_back(Field(intern(kv.first), kv.second));
+    }
+}
+
+const std::string* orocos_cpp::PkgConfig::findField(const Fields &fields, const std::string &name)
+{
+    Fields::const_iterator it = std::lower_bound(fields.begin(), fields.end(), name, field_less);
+    if(it == fields.end() || *it->first != name)
+        return nullptr;
+    return &it->second;
+}
+
+static void write_fields(std::ostream& os, const std::vector<Field>& fields)
+{
+    write_uint32(os, fields.size());
+    for(const Field& field : fields){
+        write_string(os, *field.first);
+        write_string(os, field.second);
+    }
+}
+
+static bool read_string_map(std::istream& is, std::map<std::string, std::string>& m)
+{
+    uint32_t size;
+    if(!read_uint32(is, size))
+        return false;
+    m.clear();
+    for(uint32_t i=0; i<size; i++){
+        std::string key;
+        if(!read_string(is, key) || !read_string(is, m[key]))
+            return false;
+    }
+    return true;
+}
+
 orocos_cpp::PkgConfig::PkgConfig() :
     sourceFile("")
 {
 
 }
 
-bool orocos_cpp::PkgConfig::getVariable(const std::string &fieldName, std::string& value)
+bool orocos_cpp::PkgConfig::getVariable(const std::string &fieldName, std::string& value) const
 {
-    std::map<std::string, std::string>::iterator it = variables.find(fieldName);
-    if(it == variables.end())
+    const std::string* field = findField(variables, fieldName);
+    if(!field)
         return false;
 
-    value = it->second;
+    value = *field;
     return true;
 }
 
-bool orocos_cpp::PkgConfig::getProperty(const std::string &fieldName, std::string& value)
+bool orocos_cpp::PkgConfig::getProperty(const std::string &fieldName, std::string& value) const
 {
-    std::map<std::string, std::string>::iterator it = properties.find(fieldName);
-    if(it == properties.end())
+    const std::string* field = findField(properties, fieldName);
+    if(!field)
         return false;
 
-    value = it->second;
+    value = *field;
     return true;
 }
 
 bool orocos_cpp::PkgConfig::load(const std::string &filepath)
 {
-    bool st = PkgConfigHelper::parsePkgConfig(filepath, variables, properties);
+    std::map<std::string, std::string> parsedVariables, parsedProperties;
+    bool st = PkgConfigHelper::parsePkgConfig(filepath, parsedVariables, parsedProperties);
+    assignFields(variables, parsedVariables);
+    assignFields(properties, parsedProperties);
     getProperty("Name", name);
     sourceFile = filepath;
     return st;
 }
 
-bool orocos_cpp::PkgConfig::isLoaded()
+bool orocos_cpp::PkgConfig::isLoaded() const
 {
     return !this->sourceFile.empty();
 }
 
+void orocos_cpp::PkgConfig::serialize(std::ostream &os) const
+{
+    write_string(os, name);
+    write_string(os, sourceFile);
+    write_fields(os, variables);
+    write_fields(os, properties);
+}
+
+bool orocos_cpp::PkgConfig::deserialize(std::istream &is)
+{
+    std::map<std::string, std::string> readVariables, readProperties;
+    if(!read_string(is, name) || !read_string(is, sourceFile) ||
+       !read_string_map(is, readVariables) || !read_string_map(is, readProperties))
+        return false;
+    assignFields(variables, readVariables);
+    assignFields(properties, readProperties);
+    return true;
+}
+
+//Returns a modifiable version of \p record. Records are shared with the
+//callers of the PkgConfigRegistry::get* functions and must not change, so a
+//shared record is replaced by a copy first.
+template<typename T>
+static T& writable(std::shared_ptr<T>& record)
+{
+    if(!record){
+        record = std::make_shared<T>();
+    }else if(record.use_count() > 1){
+        record = std::make_shared<T>(*record);
+    }
+    return *record;
+}
 
 bool orocos_cpp::PkgConfigRegistry::loadPackages(const std::vector<std::string>& packageNames, const std::vector<std::string>& searchPaths)
 {
@@ -62,94 +197,162 @@ bool orocos_cpp::PkgConfigRegistry::loadPackages(const std::vector<std::string>&
     return st;
 }
 
-orocos_cpp::PkgConfigRegistryPtr orocos_cpp::PkgConfigRegistry::initialize(const std::vector<std::string>& packageNames, bool loadAllPackages)
+orocos_cpp::PkgConfigRegistryPtr orocos_cpp::PkgConfigRegistry::initialize(const std::vector<std::string>& packageNames, bool loadAllPackages, const std::string& cacheFile, unsigned scanWorkers)
 {
     if(__pkgcfgreg){
         LOG_WARN_S << "PkgConfigRegistry::initialize was already called earlier!";
     }
-    __pkgcfgreg = PkgConfigRegistryPtr(new PkgConfigRegistry(packageNames, loadAllPackages));
+    __pkgcfgreg = PkgConfigRegistryPtr(new PkgConfigRegistry(packageNames, loadAllPackages, cacheFile, scanWorkers));
 
     return __pkgcfgreg;
 }
 
-bool orocos_cpp::PkgConfigRegistry::getDeployment(const std::string &name, orocos_cpp::PkgConfig &pkg, bool searchPackageIfNotLoaded)
+template<typename Ptr, typename Find>
+Ptr orocos_cpp::PkgConfigRegistry::lookup(PkgKind kind, const std::string &name, const char *description, bool searchPackageIfNotLoaded, Find find)
 {
-    std::map<std::string, PkgConfig>::iterator it = deployments.find(name);
-    if(it == deployments.end()){
-        if(!searchPackageIfNotLoaded){
-            return false;
+    pollSearchPathChanges();
+    {
+        boost::shared_lock<boost::shared_mutex> lock(registryMutex);
+        Ptr pkg = find();
+        if(pkg || !searchPackageIfNotLoaded){
+            return pkg;
         }
-        LOG_DEBUG_S << "Deployment Package " << name << " was requested but is not present in PkgConfigregistry. Trying to find it.";
-        bool st = findAndLoadPackage(name);
-        if(st){
-            return getDeployment(name, pkg, false);
-        }else{
-            return false;
+        //Packages known to be missing are answered without the exclusive lock
+        if(isKnownMissing(kind, name)){
+            nAvoidedRescans++;
+            return nullptr;
         }
     }
-    pkg = it->second;
+
+    //Searching modifies the registry. Threads looking up the same package
+    //wait here and find it loaded (or known to be missing) afterwards, so
+    //it is searched only once.
+    boost::unique_lock<boost::shared_mutex> lock(registryMutex);
+    Ptr pkg = find();
+    if(pkg){
+        return pkg;
+    }
+    LOG_DEBUG_S << description << " " << name << " was requested but is not present in PkgConfigregistry. Trying to find it.";
+    if(isKnownMissing(kind, name)){
+        nAvoidedRescans++;
+        return nullptr;
+    }
+    nRescans++;
+    bool st = findAndLoadPackage(name);
+    pkg = st ? find() : nullptr;
+    if(!pkg){
+        rememberMissing(kind, name);
+    }
+    return pkg;
+}
+
+orocos_cpp::PkgConfigConstPtr orocos_cpp::PkgConfigRegistry::getDeployment(const std::string &name, bool searchPackageIfNotLoaded)
+{
+    return lookup<PkgConfigConstPtr>(DEPLOYMENT_PKG, name, "Deployment Package", searchPackageIfNotLoaded, [&]() -> PkgConfigConstPtr {
+        std::map<std::string, PkgConfigConstPtr>::const_iterator it = deployments.find(name);
+        return it == deployments.end() ? nullptr : it->second;
+    });
+}
+
+orocos_cpp::TypekitPkgConfigConstPtr orocos_cpp::PkgConfigRegistry::getTypekit(const std::string &name, bool searchPackageIfNotLoaded)
+{
+    return lookup<TypekitPkgConfigConstPtr>(TYPEKIT_PKG, name, "Typekit Package", searchPackageIfNotLoaded, [&]() -> TypekitPkgConfigConstPtr {
+        std::map<std::string, std::shared_ptr<TypekitPkgConfig> >::const_iterator it = typekits.find(name);
+        return it == typekits.end() ? nullptr : it->second;
+    });
+}
+
+orocos_cpp::OrogenPkgConfigConstPtr orocos_cpp::PkgConfigRegistry::getOrogen(const std::string &name, bool searchPackageIfNotLoaded)
+{
+    return lookup<OrogenPkgConfigConstPtr>(OROGEN_PROJECT_PKG, name, "Orogen Package", searchPackageIfNotLoaded, [&]() -> OrogenPkgConfigConstPtr {
+        std::map<std::string, std::shared_ptr<OrogenPkgConfig> >::const_iterator it = orogen.find(name);
+        return it == orogen.end() ? nullptr : it->second;
+    });
+}
+
+orocos_cpp::PkgConfigConstPtr orocos_cpp::PkgConfigRegistry::getOrocosRTT(bool searchPackageIfNotLoaded)
+{
+    return lookup<PkgConfigConstPtr>(OROCOS_RTT_PKG, "rtt", "Orocos-RTT Package", searchPackageIfNotLoaded, [&]() -> PkgConfigConstPtr {
+        return orocosRTTPkg;
+    });
+}
+
+bool orocos_cpp::PkgConfigRegistry::isKnownMissing(PkgKind kind, const std::string &name) const
+{
+    std::map<std::pair<PkgKind, std::string>, std::chrono::steady_clock::time_point>::const_iterator it = missingPackages.find(std::make_pair(kind, name));
+    if(it == missingPackages.end() ||
+       (missingPackageTTL > std::chrono::steady_clock::duration::zero() && std::chrono::steady_clock::now() - it->second > missingPackageTTL)){
+        return false;
+    }
+    LOG_DEBUG_S << "Package " << name << " was not found by an earlier search. Skipping search.";
+    return true;
+}
+
+void orocos_cpp::PkgConfigRegistry::rememberMissing(PkgKind kind, const std::string &name)
+{
+    missingPackages[std::make_pair(kind, name)] = std::chrono::steady_clock::now();
+}
+
+void orocos_cpp::PkgConfigRegistry::forgetMissingPackages()
+{
+    boost::unique_lock<boost::shared_mutex> lock(registryMutex);
+    missingPackages.clear();
+}
+
+void orocos_cpp::PkgConfigRegistry::setMissingPackageTTL(double seconds)
+{
+    boost::unique_lock<boost::shared_mutex> lock(registryMutex);
+    missingPackageTTL = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+orocos_cpp::PkgConfigRegistry::LookupStatistics orocos_cpp::PkgConfigRegistry::getLookupStatistics() const
+{
+    LookupStatistics statistics;
+    statistics.rescans = nRescans;
+    statistics.avoidedRescans = nAvoidedRescans;
+    return statistics;
+}
+
+bool orocos_cpp::PkgConfigRegistry::getDeployment(const std::string &name, orocos_cpp::PkgConfig &pkg, bool searchPackageIfNotLoaded)
+{
+    PkgConfigConstPtr p = getDeployment(name, searchPackageIfNotLoaded);
+    if(!p)
+        return false;
+    pkg = *p;
     return true;
 }
 
 bool orocos_cpp::PkgConfigRegistry::getTypekit(const std::string &name, orocos_cpp::TypekitPkgConfig &pkg, bool searchPackageIfNotLoaded)
 {
-    std::map<std::string, TypekitPkgConfig>::iterator it = typekits.find(name);
-    if(it == typekits.end()){
-        if(!searchPackageIfNotLoaded){
-            return false;
-        }
-        LOG_DEBUG_S << "Typekit Package " << name << " was requested but is not present in PkgConfigregistry. Trying to find it.";
-        bool st = findAndLoadPackage(name);
-        if(st){
-            return getTypekit(name, pkg, false);
-        }else{
-            return false;
-        }
-    }
-    pkg = it->second;
+    TypekitPkgConfigConstPtr p = getTypekit(name, searchPackageIfNotLoaded);
+    if(!p)
+        return false;
+    pkg = *p;
     return true;
 }
 
 bool orocos_cpp::PkgConfigRegistry::getOrogen(const std::string &name, orocos_cpp::OrogenPkgConfig &pkg, bool searchPackageIfNotLoaded)
 {
-    std::map<std::string, OrogenPkgConfig>::iterator it = orogen.find(name);
-    if(it == orogen.end()){
-        if(!searchPackageIfNotLoaded){
-            return false;
-        }
-        LOG_DEBUG_S << "Orogen Package " << name << " was requested but is not present in PkgConfigregistry. Trying to find it.";
-        bool st = findAndLoadPackage(name);
-        if(st){
-            return getOrogen(name, pkg, false);
-        }else{
-            return false;
-        }
-    }
-    pkg = it->second;
+    OrogenPkgConfigConstPtr p = getOrogen(name, searchPackageIfNotLoaded);
+    if(!p)
+        return false;
+    pkg = *p;
     return true;
 }
 
 bool orocos_cpp::PkgConfigRegistry::getOrocosRTT(orocos_cpp::PkgConfig &pkg, bool searchPackageIfNotLoaded)
 {
-    if(!orocosRTTPkg.isLoaded()){
-        if(!searchPackageIfNotLoaded){
-            return false;
-        }
-        LOG_DEBUG_S << "The Orocos-RTT Package was requested but is not present in PkgConfigregistry. Trying to find it.";
-        bool st = findAndLoadPackage("rtt");
-        if(st){
-            return getOrocosRTT(pkg, false);
-        }else{
-            return false;
-        }
-    }else{
-        pkg = orocosRTTPkg;
-        return true;
-    }
+    PkgConfigConstPtr p = getOrocosRTT(searchPackageIfNotLoaded);
+    if(!p)
+        return false;
+    pkg = *p;
+    return true;
 }
 
 std::vector<std::string> orocos_cpp::PkgConfigRegistry::getRegisteredDeploymentNames()
 {
+    pollSearchPathChanges();
+    boost::shared_lock<boost::shared_mutex> lock(registryMutex);
     std::vector<std::string> ret;
     extract_keys(deployments, ret);
     return ret;
@@ -157,6 +360,8 @@ std::vector<std::string> orocos_cpp::PkgConfigRegistry::getRegisteredDeploymentN
 
 std::vector<std::string> orocos_cpp::PkgConfigRegistry::getRegisteredTypekitNames()
 {
+    pollSearchPathChanges();
+    boost::shared_lock<boost::shared_mutex> lock(registryMutex);
     std::vector<std::string> ret;
     extract_keys(typekits, ret);
     return ret;
@@ -164,11 +369,99 @@ std::vector<std::string> orocos_cpp::PkgConfigRegistry::getRegisteredTypekitName
 
 std::vector<std::string> orocos_cpp::PkgConfigRegistry::getRegisteredOrogenNames()
 {
+    pollSearchPathChanges();
+    boost::shared_lock<boost::shared_mutex> lock(registryMutex);
     std::vector<std::string> ret;
     extract_keys(orogen, ret);
     return ret;
 }
 
+std::vector<orocos_cpp::DeployedTask> orocos_cpp::PkgConfigRegistry::getDeployedTasksOfModel(const std::string &model)
+{
+    pollSearchPathChanges();
+    boost::shared_lock<boost::shared_mutex> lock(registryMutex);
+    std::unordered_map<std::string, std::vector<DeployedTask> >::const_iterator it = modelIndex.find(model);
+    return it == modelIndex.end() ? std::vector<DeployedTask>() : it->second;
+}
+
+bool orocos_cpp::PkgConfigRegistry::getDeployedTask(const std::string &taskName, DeployedTask &task)
+{
+    pollSearchPathChanges();
+    boost::shared_lock<boost::shared_mutex> lock(registryMutex);
+    std::unordered_map<std::string, std::vector<DeployedTask> >::const_iterator it = taskIndex.find(taskName);
+    if(it == taskIndex.end() || it->second.empty()){
+        return false;
+    }
+    task = it->second.front();
+    return true;
+}
+
+//Extracts the tasks of a deployment from its 'deployed_tasks_with_models'
+//variable, e.g. 'consumer,rock_runtime_evaluation::MessageConsumer,producer,...'
+//Falls back to 'deployed_tasks' without models for older packages.
+static std::vector<orocos_cpp::DeployedTask> get_deployed_tasks(const std::string& deploymentName, const orocos_cpp::PkgConfig& pkg)
+{
+    std::vector<orocos_cpp::DeployedTask> ret;
+    std::string value;
+    bool withModels = pkg.getVariable("deployed_tasks_with_models", value);
+    if(!withModels && !pkg.getVariable("deployed_tasks", value)){
+        return ret;
+    }
+    std::vector<std::string> tokens = orocos_cpp::PkgConfigHelper::vectorizeTokenSeparatedString(value, ",");
+    for(size_t i = 0; i < tokens.size(); i += withModels ? 2 : 1){
+        orocos_cpp::DeployedTask task;
+        task.deployment = deploymentName;
+        task.task = tokens[i];
+        if(withModels && i+1 < tokens.size()){
+            task.model = tokens[i+1];
+        }
+        ret.push_back(task);
+    }
+    return ret;
+}
+
+void orocos_cpp::PkgConfigRegistry::setDeployment(const std::string &name, PkgConfigConstPtr pkg)
+{
+    std::map<std::string, PkgConfigConstPtr>::iterator it = deployments.find(name);
+    if(it != deployments.end()){
+        //Remove the tasks of the replaced deployment from the indexes
+        for(const DeployedTask& task : get_deployed_tasks(name, *it->second)){
+            std::vector<DeployedTask>& byTask = taskIndex[task.task];
+            byTask.erase(std::remove_if(byTask.begin(), byTask.end(), [&name](const DeployedTask& t){ return t.deployment == name; }), byTask.end());
+            if(byTask.empty()){
+                taskIndex.erase(task.task);
+            }
+            if(!task.model.empty()){
+                std::vector<DeployedTask>& byModel = modelIndex[task.model];
+                byModel.erase(std::remove_if(byModel.begin(), byModel.end(), [&name](const DeployedTask& t){ return t.deployment == name; }), byModel.end());
+                if(byModel.empty()){
+                    modelIndex.erase(task.model);
+                }
+            }
+        }
+        deployments.erase(it);
+    }
+    if(!pkg){
+        return;
+    }
+
+    deployments[name] = pkg;
+    for(const DeployedTask& task : get_deployed_tasks(name, *pkg)){
+        taskIndex[task.task].push_back(task);
+        if(!task.model.empty()){
+            modelIndex[task.model].push_back(task);
+        }
+    }
+}
+
+std::vector<orocos_cpp::DeployedTask> orocos_cpp::PkgConfigRegistry::getDeployedTasks(const std::string &deploymentName)
+{
+    pollSearchPathChanges();
+    boost::shared_lock<boost::shared_mutex> lock(registryMutex);
+    std::map<std::string, PkgConfigConstPtr>::const_iterator it = deployments.find(deploymentName);
+    return it == deployments.end() ? std::vector<DeployedTask>() : get_deployed_tasks(deploymentName, *it->second);
+}
+
 orocos_cpp::PkgConfigRegistryPtr orocos_cpp::PkgConfigRegistry::get()
 {
     if(!__pkgcfgreg){
@@ -179,11 +472,22 @@ orocos_cpp::PkgConfigRegistryPtr orocos_cpp::PkgConfigRegistry::get()
     return __pkgcfgreg;
 }
 
-orocos_cpp::PkgConfigRegistry::PkgConfigRegistry(const std::vector<std::string> &packageNames, bool loadAllPackages)
+orocos_cpp::PkgConfigRegistry::PkgConfigRegistry(const std::vector<std::string> &packageNames, bool loadAllPackages, const std::string& cacheFile, unsigned scanWorkers) :
+    missingPackageTTL(std::chrono::steady_clock::duration::zero()),
+    nRescans(0),
+    nAvoidedRescans(0),
+    searchPaths(PkgConfigHelper::getSearchPathsFromEnvVar()),
+    allPackagesLoaded(loadAllPackages)
 {
-    std::vector<std::string> searchPaths = PkgConfigHelper::getSearchPathsFromEnvVar();
     if(loadAllPackages){
-        this->loadAllPackages(searchPaths);
+        if(!cacheFile.empty() && loadCache(cacheFile, searchPaths)){
+            LOG_INFO_S << "Loaded all packages from cache " << cacheFile;
+            return;
+        }
+        this->loadAllPackages(searchPaths, scanWorkers);
+        if(!cacheFile.empty() && !saveCache(cacheFile, searchPaths)){
+            LOG_WARN_S << "Could not write PkgConfig cache " << cacheFile;
+        }
     }else{
         loadPackages(packageNames, searchPaths);
     }
@@ -285,141 +589,237 @@ bool orocos_cpp::PkgConfigRegistry::isOrocosRTTPkg(const std::string &filename,
     return false;
 }
 
-bool orocos_cpp::PkgConfigRegistry::addFile(const std::string &filepath)
+//Characters matched by \w in the file name patterns of the is*Pkg functions
+static inline bool is_word_char(char c)
 {
-    std::string typekitName, orogenProjectName, deploymentName, arch, transportName;
-    PkgConfig pkg;
-    boost::filesystem::path p(filepath);
-    std::string filename = p.filename().string();
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+//A segment of a file name between two '-' characters
+struct NameSegment
+{
+    const char* begin;
+    size_t size;
+    bool operator==(const char* s) const
+    {
+        return strncmp(begin, s, size) == 0 && s[size] == '\0';
+    }
+    std::string str() const
+    {
+        return std::string(begin, size);
+    }
+};
 
+orocos_cpp::PkgConfigRegistry::PkgKind orocos_cpp::PkgConfigRegistry::classifyFile(const std::string &filename, std::string &name, std::string &transportName)
+{
     //In Rock different special kinds of libraries can be identified by patterns in their file
     //names. Following the type of a library is identifyied by the name of the corresponding
     //PkgConfig file.
-
-    //Is Deployment?
-    if(isDeploymentPkg(filename, deploymentName)){
-        bool st = pkg.load(filepath);
-        std::map<std::string, PkgConfig>::iterator it = deployments.find(deploymentName);
-        if(it != deployments.end()){
-            LOG_WARN_S << "Ignoring PKGConfig file "<<filepath<<", because it describes a deployment with name " << deploymentName << ", but there was already a PKGConfig file for the same deployment added with the file " << it->second.sourceFile << ".";
-            return false;
-        }
-        deployments[deploymentName] = pkg;
-        return st;
+    //All patterns consist of 2 to 4 non-empty words separated by '-', followed by '.pc'.
+    //Thus the file name is split once into its segments, which are then compared with the
+    //patterns in the same order as isDeploymentPkg, isProxiesPkg, isOrogenProjectPkg,
+    //isOrogenTasksPkg, isTransportPkg, isTypekitPkg and isOrocosRTTPkg are checked.
+    static const size_t max_segments = 4;
+    if(filename.size() < 3 || filename.compare(filename.size() - 3, 3, ".pc") != 0)
+        return UNKNOWN_PKG;
+
+    NameSegment seg[max_segments];
+    size_t n_seg = 0;
+    const char* c = filename.data();
+    const char* const end = c + filename.size() - 3;
+    while(true){
+        if(n_seg == max_segments)
+            return UNKNOWN_PKG;
+        const char* begin = c;
+        while(c != end && is_word_char(*c))
+            ++c;
+        if(c == begin)
+            return UNKNOWN_PKG;
+        seg[n_seg].begin = begin;
+        seg[n_seg].size = c - begin;
+        ++n_seg;
+        if(c == end)
+            break;
+        if(*c != '-')
+            return UNKNOWN_PKG;
+        ++c;
     }
 
-    //Is Proxy?
-    else if(isProxiesPkg(filename, orogenProjectName)){
-        bool st = pkg.load(filepath);
-        std::map<std::string, OrogenPkgConfig>::iterator it = orogen.find(orogenProjectName);
-
-        if(it == orogen.end()){
-            orogen[orogenProjectName] = OrogenPkgConfig();
-            it = orogen.find(orogenProjectName);
+    if(n_seg == 2){
+        if(seg[0] == "orogen"){
+            name = seg[1].str();
+            return DEPLOYMENT_PKG;
         }
-
-        if(it->second.proxies.isLoaded()){
-            LOG_WARN_S << "Ignoring PKGConfig file "<<filepath<<", because it describes task proxies for the orogen project " << orogenProjectName << ", but they were already be imported from the PKGConfig file " << it->second.proxies.sourceFile << ".";
-            return false;
+        if(seg[1] == "proxies"){
+            name = seg[0].str();
+            return PROXIES_PKG;
         }
-        it->second.proxies = pkg;
-        return st;
-    }
-
-    //Is OrogenProject
-    else if(isOrogenProjectPkg(filename, orogenProjectName)){
-        bool st = pkg.load(filepath);
-        std::map<std::string, OrogenPkgConfig>::iterator it = orogen.find(orogenProjectName);
-
-        if(it == orogen.end()){
-            orogen[orogenProjectName] = OrogenPkgConfig();
-            it = orogen.find(orogenProjectName);
+    }else if(n_seg == 3){
+        if(seg[0] == "orogen" && seg[1] == "project"){
+            name = seg[2].str();
+            return OROGEN_PROJECT_PKG;
         }
-
-        if(it->second.project.isLoaded()){
-            LOG_WARN_S << "Ignoring PKGConfig file "<<filepath<<", because it describes the orogen project " << orogenProjectName << ", but it was already described by the PKGConfig file " << it->second.project.sourceFile << ".";
-            return false;
+        if(seg[1] == "tasks"){
+            name = seg[0].str();
+            return OROGEN_TASKS_PKG;
+        }
+        if(seg[1] == "typekit"){
+            name = seg[0].str();
+            return TYPEKIT_PKG;
+        }
+        //RTT follows a different convention. Kind of library is determined by folder they are installed in.
+        if(seg[0] == "orocos" && seg[1] == "rtt"){
+            return OROCOS_RTT_PKG;
+        }
+    }else if(n_seg == 4){
+        if(seg[1] == "transport"){
+            name = seg[0].str();
+            transportName = seg[2].str();
+            return TRANSPORT_PKG;
         }
-        it->second.project = pkg;
-        return st;
     }
+    return UNKNOWN_PKG;
+}
 
-    //Is OrogenTasks
-    else if(isOrogenTasksPkg(filename, orogenProjectName, arch)){
-        bool st = pkg.load(filepath);
-        std::map<std::string, OrogenPkgConfig>::iterator it = orogen.find(orogenProjectName);
-
-        if(it == orogen.end()){
-            orogen[orogenProjectName] = OrogenPkgConfig();
-            it = orogen.find(orogenProjectName);
+bool orocos_cpp::PkgConfigRegistry::registerPkg(PkgKind kind, const std::string &name, const std::string &transportName, const PkgConfig &pkg)
+{
+    const std::string& filepath = pkg.sourceFile;
+    switch(kind){
+    case DEPLOYMENT_PKG:
+    {
+        std::map<std::string, PkgConfigConstPtr>::iterator it = deployments.find(name);
+        if(it != deployments.end()){
+            LOG_WARN_S << "Ignoring PKGConfig file "<<filepath<<", because it describes a deployment with name " << name << ", but there was already a PKGConfig file for the same deployment added with the file " << it->second->sourceFile << ".";
+            return false;
         }
-
-        if(it->second.tasks.isLoaded()){
-            LOG_WARN_S << "Ignoring PKGConfig file "<<filepath<<", because it describes the tasks for the orogen project " << orogenProjectName << ", but the tasks were already described by the PKGConfig file " << it->second.tasks.sourceFile << ".";
+        setDeployment(name, std::make_shared<PkgConfig>(pkg));
+        return true;
+    }
+    case PROXIES_PKG:
+    {
+        OrogenPkgConfig& opkg = writable(orogen[name]);
+        if(opkg.proxies.isLoaded()){
+            LOG_WARN_S << "Ignoring PKGConfig file "<<filepath<<", because it describes task proxies for the orogen project " << name << ", but they were already be imported from the PKGConfig file " << opkg.proxies.sourceFile << ".";
             return false;
         }
-        it->second.tasks = pkg;
-        return st;
+        opkg.proxies = pkg;
+        return true;
     }
-
-    //Is Transports
-    else if(isTransportPkg(filename, typekitName, transportName, arch)){
-        bool st = pkg.load(filepath);
-        std::map<std::string, TypekitPkgConfig>::iterator it = typekits.find(typekitName);
-
-        if(it == typekits.end()){
-            typekits[typekitName] = TypekitPkgConfig();
-            it = typekits.find(typekitName);
+    case OROGEN_PROJECT_PKG:
+    {
+        OrogenPkgConfig& opkg = writable(orogen[name]);
+        if(opkg.project.isLoaded()){
+            LOG_WARN_S << "Ignoring PKGConfig file "<<filepath<<", because it describes the orogen project " << name << ", but it was already described by the PKGConfig file " << opkg.project.sourceFile << ".";
+            return false;
         }
-
-        std::map<std::string, PkgConfig>::iterator transportit = it->second.transports.find(transportName);
-        if(transportit != it->second.transports.end()){
-            LOG_WARN_S << "Ignoring PKGConfig file "<<filepath<<", because it describes the transport " << transportName << " for typekit " << typekitName << ", but the transport was already described by the PKGConfig file " << transportit->second.sourceFile << ".";
+        opkg.project = pkg;
+        return true;
+    }
+    case OROGEN_TASKS_PKG:
+    {
+        OrogenPkgConfig& opkg = writable(orogen[name]);
+        if(opkg.tasks.isLoaded()){
+            LOG_WARN_S << "Ignoring PKGConfig file "<<filepath<<", because it describes the tasks for the orogen project " << name << ", but the tasks were already described by the PKGConfig file " << opkg.tasks.sourceFile << ".";
             return false;
         }
-        it->second.transports[transportName] = pkg;
-        return st;
+        opkg.tasks = pkg;
+        return true;
     }
-
-    //Is Typekit
-    else if(isTypekitPkg(filename, typekitName, arch)){
-        bool st = pkg.load(filepath);
-        std::map<std::string, TypekitPkgConfig>::iterator it = typekits.find(typekitName);
-        if(it == typekits.end()){
-            typekits[typekitName] = TypekitPkgConfig();
-            it = typekits.find(typekitName);
+    case TRANSPORT_PKG:
+    {
+        TypekitPkgConfig& tpkg = writable(typekits[name]);
+        std::map<std::string, PkgConfig>::iterator transportit = tpkg.transports.find(transportName);
+        if(transportit != tpkg.transports.end()){
+            LOG_WARN_S << "Ignoring PKGConfig file "<<filepath<<", because it describes the transport " << transportName << " for typekit " << name << ", but the transport was already described by the PKGConfig file " << transportit->second.sourceFile << ".";
+            return false;
         }
-
-        if(it->second.typekit.isLoaded()){
-            LOG_WARN_S << "Ignoring PKGConfig file "<<filepath<<", because it describes the typekit " << typekitName << ", but the typekit was already described by the PKGConfig file " << it->second.typekit.sourceFile << ".";
+        tpkg.transports[transportName] = pkg;
+        return true;
+    }
+    case TYPEKIT_PKG:
+    {
+        TypekitPkgConfig& tpkg = writable(typekits[name]);
+        if(tpkg.typekit.isLoaded()){
+            LOG_WARN_S << "Ignoring PKGConfig file "<<filepath<<", because it describes the typekit " << name << ", but the typekit was already described by the PKGConfig file " << tpkg.typekit.sourceFile << ".";
             return false;
         }
-        it->second.typekit = pkg;
-        return st;
+        tpkg.typekit = pkg;
+        return true;
     }
-
-    //IS OrocosRTT
-    //RTT follows a different convention. Kind of library is determined by folder they are installed in.
-    else if(isOrocosRTTPkg(filename, arch)){
-        if(orocosRTTPkg.isLoaded()){
-            LOG_WARN_S << "Ignoring PkgConfig file " << filepath << ". It describes the package orocos-rtt, but that was already described by the PkgConfig file "<<orocosRTTPkg.sourceFile;
+    case OROCOS_RTT_PKG:
+    {
+        if(orocosRTTPkg){
+            LOG_WARN_S << "Ignoring PkgConfig file " << filepath << ". It describes the package orocos-rtt, but that was already described by the PkgConfig file "<<orocosRTTPkg->sourceFile;
             return false;
         }
-
-        bool st = pkg.load(filepath);
-        orocosRTTPkg = pkg;
-        return st;
+        orocosRTTPkg = std::make_shared<PkgConfig>(pkg);
+        return true;
     }
-    else{
+    default:
         //Do nothing.. we don't load pkgconfig files for arbitrary libraries, since we'll not need them.
         return false;
     }
 }
 
+bool orocos_cpp::PkgConfigRegistry::addFile(const std::string &filepath)
+{
+    std::string name, transportName;
+    boost::filesystem::path p(filepath);
+    PkgKind kind = classifyFile(p.filename().string(), name, transportName);
+    if(kind == UNKNOWN_PKG){
+        return false;
+    }
+    if(kind == OROCOS_RTT_PKG && orocosRTTPkg){
+        LOG_WARN_S << "Ignoring PkgConfig file " << filepath << ". It describes the package orocos-rtt, but that was already described by the PkgConfig file "<<orocosRTTPkg->sourceFile;
+        return false;
+    }
+
+    PkgConfig pkg;
+    bool st = pkg.load(filepath);
+    return registerPkg(kind, name, transportName, pkg) && st;
+}
+
+
+const std::unordered_set<std::string>* orocos_cpp::PkgConfigRegistry::listDirectory(const std::string &dirpath)
+{
+    //'dir/' and 'dir' share one entry
+    std::string path = dirpath;
+    while(path.size() > 1 && path[path.size()-1] == '/'){
+        path.resize(path.size()-1);
+    }
+
+    std::map<std::string, DirectoryListing>::iterator it = directoryIndex.find(path);
+    if(it == directoryIndex.end()){
+        DirectoryListing& listing = directoryIndex[path];
+        boost::system::error_code ec;
+        listing.valid = fs::is_directory(path, ec);
+        if(listing.valid){
+            for(fs::directory_iterator itr(path, ec); !ec && itr!=fs::directory_iterator(); itr.increment(ec)){
+                listing.files.insert(itr->path().filename().string());
+            }
+        }
+        it = directoryIndex.find(path);
+    }
+    return it->second.valid ? &it->second.files : nullptr;
+}
+
+bool orocos_cpp::PkgConfigRegistry::hasFile(const fs::path &filepath)
+{
+    const std::unordered_set<std::string>* files = listDirectory(filepath.parent_path().string());
+    return files && files->count(filepath.filename().string());
+}
+
+void orocos_cpp::PkgConfigRegistry::refreshDirectoryIndex()
+{
+    boost::unique_lock<boost::shared_mutex> lock(registryMutex);
+    directoryIndex.clear();
+    missingPackages.clear();
+}
 
-bool load_pkg(const fs::path& pkg_path, orocos_cpp::PkgConfig& pkg)
+bool orocos_cpp::PkgConfigRegistry::loadPkg(const fs::path& pkg_path, orocos_cpp::PkgConfig& pkg)
 {
-    if(!fs::exists(pkg_path)){
+    if(!hasFile(pkg_path)){
         LOG_WARN_S << "File " << pkg_path << " not found.";
     }else{
         bool st = pkg.load(pkg_path.string());
@@ -450,35 +850,35 @@ bool orocos_cpp::PkgConfigRegistry::loadOrogenPkg(const fs::path &filepath)
         LOG_ERROR_S << "Error loading PkgConfig file of OroGen Project-package "<<package_name<<" from "<<filepath.string();
         return st;
     }
-    OrogenPkgConfig opkg;
-    opkg.project = pkg_proj;
+    std::shared_ptr<OrogenPkgConfig> opkg = std::make_shared<OrogenPkgConfig>();
+    opkg->project = pkg_proj;
 
     //Load Tasks package, if it is defined
     PkgConfig pkg;
     fs::path pkg_path = pkg_search_path / (package_name + "-tasks-"+target+".pc");
-    st = load_pkg(pkg_path, pkg);
-    opkg.tasks = pkg;
+    st = loadPkg(pkg_path, pkg);
+    opkg->tasks = pkg;
     //Load Proxies package, if it is defined
     pkg_path = pkg_search_path / (package_name + "-proxies" + ".pc");
-    st = load_pkg(pkg_path, pkg);
-    opkg.proxies = pkg;
+    st = loadPkg(pkg_path, pkg);
+    opkg->proxies = pkg;
 
     //store orogen package
     orogen[package_name] = opkg;
 
     //Load typekit-PkgConfig, if it is defined
     pkg_path = pkg_search_path / (package_name + "-typekit-"+target+".pc");
-    st = load_pkg(pkg_path, pkg);
+    st = loadPkg(pkg_path, pkg);
     if(st){
-        TypekitPkgConfig tpkg;
-        tpkg.typekit = pkg;
+        std::shared_ptr<TypekitPkgConfig> tpkg = std::make_shared<TypekitPkgConfig>();
+        tpkg->typekit = pkg;
 
         //Load transports-PkgConfig, if it is defined
         for(const std::string& t : known_transports){
             pkg_path = pkg_search_path / (package_name + "-transport-" + t + "-"  +target + ".pc");
-            st = load_pkg(pkg_path, pkg);
+            st = loadPkg(pkg_path, pkg);
             if(st){
-                tpkg.transports[t] = pkg;
+                tpkg->transports[t] = pkg;
             }
         }
         typekits[package_name] = tpkg;
@@ -494,8 +894,8 @@ bool orocos_cpp::PkgConfigRegistry::loadDeploymentPkg(const fs::path &filepath)
 
     //Load deployment
     PkgConfig pkg;
-    bool st = load_pkg(filepath, pkg);
-    deployments[package_name] = pkg;
+    bool st = loadPkg(filepath, pkg);
+    setDeployment(package_name, std::make_shared<PkgConfig>(pkg));
     return st;
 }
 
@@ -509,7 +909,9 @@ bool orocos_cpp::PkgConfigRegistry::findAndLoadPackage(const std::string& pname,
 
     LOG_DEBUG_S << "Searching for package " << pname;
     for(const fs::path& path : searchPaths){
-        if(!fs::is_directory(path)){
+        //All file lookups below are answered by the directory index, so each
+        //search path is only listed once
+        if(!listDirectory(path.string())){
             LOG_WARN_S << "Skipping directory " << path << " since it is not a valid directory";
             continue;
         }
@@ -518,26 +920,26 @@ bool orocos_cpp::PkgConfigRegistry::findAndLoadPackage(const std::string& pname,
         if(pname == "rtt" || pname == "orocos-rtt"){
             std::string target = std::getenv("OROCOS_TARGET");
             fpath = path / ("orocos-rtt-"+target+".pc");
-            if(fs::exists(fpath)){
+            if(hasFile(fpath)){
                 LOG_DEBUG_S << "PkgConfig for RTT Package was found in file " << fpath;
                 PkgConfig pkg;
                 bool st = pkg.load(fpath.string());
                 if(st){
                     LOG_INFO_S << "PkgConfig " << fpath << "  for the RTT Package was sucessfully loaded";
-                    orocosRTTPkg = pkg;
+                    orocosRTTPkg = std::make_shared<PkgConfig>(pkg);
                     found = true;
                 }else{
                     LOG_ERROR_S << "Error loading Orocos-RTT PkgConfig file from " << fpath;
                 }
 
                 //load transports for rtt
-                TypekitPkgConfig tpkg;
+                std::shared_ptr<TypekitPkgConfig> tpkg = std::make_shared<TypekitPkgConfig>();
                 std::vector<std::string> known_transports = {"corba","mqueue","typelib"};
                 for(const std::string& t : known_transports){
                     fpath = path / ("orocos-rtt-"+t+"-"+target+".pc");
-                    if(pkg.load(fpath.string())){
+                    if(hasFile(fpath) && pkg.load(fpath.string())){
                         LOG_INFO_S << "Loaded transport " << t << " for RTT package from " << fpath;
-                        tpkg.transports[t] = pkg;
+                        tpkg->transports[t] = pkg;
                     }else{
                         LOG_INFO_S << "Could not load transport " << t << " for RTT package from " << fpath;
                     }
@@ -549,7 +951,7 @@ bool orocos_cpp::PkgConfigRegistry::findAndLoadPackage(const std::string& pname,
 
         //Check for oroGen package
         fpath = path / ("orogen-project-"+pname+".pc");
-        if(fs::exists(fpath)){
+        if(hasFile(fpath)){
             LOG_DEBUG_S << "PkgConfig for Orogen Package with name " << pname << " found in file " << fpath;
             bool st = loadOrogenPkg(fpath);
             if(st){
@@ -562,7 +964,7 @@ bool orocos_cpp::PkgConfigRegistry::findAndLoadPackage(const std::string& pname,
 
         //Check for Deployment package
         fpath = path / ("orogen-"+pname+".pc");
-        if(fs::exists(fpath)){
+        if(hasFile(fpath)){
             LOG_DEBUG_S << "PkgConfig for Orogen Deployment Package with name " << pname << " found in file " << fpath;
             bool st = loadDeploymentPkg(fpath);
             if(st){
@@ -577,26 +979,479 @@ bool orocos_cpp::PkgConfigRegistry::findAndLoadPackage(const std::string& pname,
     return found;
 }
 
-void orocos_cpp::PkgConfigRegistry::loadAllPackages(const std::vector<std::string> &searchPaths)
+void orocos_cpp::PkgConfigRegistry::loadAllPackages(const std::vector<std::string> &searchPaths, unsigned nWorkers)
 {
     LOG_INFO_S << "Loading all packages defined in search path";
-    for(const std::string& path : searchPaths){
+    if(nWorkers == 0){
+        nWorkers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if(nWorkers == 1){
+        for(const std::string& path : searchPaths){
+            LOG_DEBUG_S << "Scanning " << path;
+            if(!fs::is_directory(path)){
+                LOG_WARN_S << "Skipping directory " << path << " since it is not a valid directory";
+                continue;
+            }
+            for (fs::directory_iterator itr(path); itr!=fs::directory_iterator(); ++itr)
+            {
+                if( fs::is_regular_file(*itr) ){
+                    bool st = addFile(itr->path().string());
+                    if(st){
+                        LOG_INFO_S << "Loaded PkgConfig file " << itr->path().string() << "\t" << "[OK]";
+                    }else{
+                        LOG_INFO_S << "Loaded PkgConfig file " << itr->path().string() << "\t" << "[IGNORED]";
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    //List all search paths in parallel
+    std::vector<std::vector<std::string> > listings(searchPaths.size());
+    parallel_for(searchPaths.size(), nWorkers, [&](size_t i){
+        const std::string& path = searchPaths[i];
         LOG_DEBUG_S << "Scanning " << path;
-        if(!fs::is_directory(path)){
+        boost::system::error_code ec;
+        if(!fs::is_directory(path, ec)){
             LOG_WARN_S << "Skipping directory " << path << " since it is not a valid directory";
-            continue;
+            return;
         }
-        for (fs::directory_iterator itr(path); itr!=fs::directory_iterator(); ++itr)
+        for (fs::directory_iterator itr(path, ec); !ec && itr!=fs::directory_iterator(); itr.increment(ec))
         {
-            if( fs::is_regular_file(*itr) ){
-                bool st = addFile(itr->path().string());
-                if(st){
-                    LOG_INFO_S << "Loaded PkgConfig file " << itr->path().string() << "\t" << "[OK]";
-                }else{
-                    LOG_INFO_S << "Loaded PkgConfig file " << itr->path().string() << "\t" << "[IGNORED]";
-                }
+            if( fs::is_regular_file(itr->status()) ){
+                listings[i].push_back(itr->path().string());
+            }
+        }
+    });
+
+    //Parse all relevant files in parallel
+    struct ScannedFile
+    {
+        std::string filepath;
+        PkgKind kind;
+        std::string name, transportName;
+        PkgConfig pkg;
+        bool st;
+    };
+    std::vector<ScannedFile> files;
+    for(const std::vector<std::string>& listing : listings){
+        for(const std::string& filepath : listing){
+            files.push_back(ScannedFile());
+            files.back().filepath = filepath;
+        }
+    }
+    parallel_for(files.size(), nWorkers, [&](size_t i){
+        ScannedFile& f = files[i];
+        f.kind = classifyFile(fs::path(f.filepath).filename().string(), f.name, f.transportName);
+        f.st = f.kind != UNKNOWN_PKG && f.pkg.load(f.filepath);
+    });
+
+    //Merge in search path order, so that the first file found for a package
+    //wins like in the serial scan
+    for(const ScannedFile& f : files){
+        bool st = f.kind != UNKNOWN_PKG && registerPkg(f.kind, f.name, f.transportName, f.pkg) && f.st;
+        if(st){
+            LOG_INFO_S << "Loaded PkgConfig file " << f.filepath << "\t" << "[OK]";
+        }else{
+            LOG_INFO_S << "Loaded PkgConfig file " << f.filepath << "\t" << "[IGNORED]";
+        }
+    }
+}
+
+//Identifies the version of the cache file format
+static const char cache_magic[] = "orocos_cpp-pkgconfig-cache-1";
+
+//!
+//! \brief Builds the key a cache file is valid for
+//! The key consists of OROCOS_TARGET and the search paths together with their
+//! modification times. Adding, removing or renaming a PkgConfig file changes
+//! the modification time of its directory and thus invalidates the cache.
+//!
+static std::string make_cache_key(const std::vector<std::string>& searchPaths)
+{
+    std::ostringstream key;
+    const char* target = std::getenv("OROCOS_TARGET");
+    write_string(key, target ? target : "");
+    write_uint32(key, searchPaths.size());
+    for(const std::string& path : searchPaths){
+        write_string(key, path);
+        struct stat st;
+        int64_t mtime[2] = {-1, -1};
+        if(stat(path.c_str(), &st) == 0){
+            mtime[0] = st.st_mtim.tv_sec;
+            mtime[1] = st.st_mtim.tv_nsec;
+        }
+        key.write(reinterpret_cast<const char*>(mtime), sizeof(mtime));
+    }
+    return key.str();
+}
+
+bool orocos_cpp::PkgConfigRegistry::loadCache(const std::string &cacheFile, const std::vector<std::string> &searchPaths)
+{
+    std::ifstream is(cacheFile, std::ios::in | std::ios::binary);
+    if(!is.is_open()){
+        LOG_INFO_S << "PkgConfig cache " << cacheFile << " does not exist";
+        return false;
+    }
+
+    std::string magic, key;
+    if(!read_string(is, magic) || magic != cache_magic ||
+       !read_string(is, key) || key != make_cache_key(searchPaths)){
+        LOG_INFO_S << "PkgConfig cache " << cacheFile << " is outdated";
+        return false;
+    }
+
+    std::map<std::string, PkgConfigConstPtr> cached_deployments;
+    std::map<std::string, std::shared_ptr<OrogenPkgConfig> > cached_orogen;
+    std::map<std::string, std::shared_ptr<TypekitPkgConfig> > cached_typekits;
+    PkgConfig cached_rtt;
+    uint32_t size;
+    bool ok = read_uint32(is, size);
+    for(uint32_t i=0; ok && i<size; i++){
+        std::string name;
+        std::shared_ptr<PkgConfig> pkg = std::make_shared<PkgConfig>();
+        ok = read_string(is, name) && pkg->deserialize(is);
+        cached_deployments[name] = pkg;
+    }
+    ok = ok && read_uint32(is, size);
+    for(uint32_t i=0; ok && i<size; i++){
+        std::string name;
+        ok = read_string(is, name);
+        OrogenPkgConfig& opkg = writable(cached_orogen[name]);
+        ok = ok && opkg.tasks.deserialize(is) && opkg.project.deserialize(is) && opkg.proxies.deserialize(is);
+    }
+    ok = ok && read_uint32(is, size);
+    for(uint32_t i=0; ok && i<size; i++){
+        std::string name;
+        uint32_t n_transports;
+        ok = read_string(is, name);
+        TypekitPkgConfig& tpkg = writable(cached_typekits[name]);
+        ok = ok && tpkg.typekit.deserialize(is) && read_uint32(is, n_transports);
+        for(uint32_t j=0; ok && j<n_transports; j++){
+            std::string transport;
+            ok = read_string(is, transport) && tpkg.transports[transport].deserialize(is);
+        }
+    }
+    ok = ok && cached_rtt.deserialize(is);
+    if(!ok){
+        LOG_WARN_S << "PkgConfig cache " << cacheFile << " is corrupt";
+        return false;
+    }
+
+    deployments.clear();
+    modelIndex.clear();
+    taskIndex.clear();
+    for(const auto& kv : cached_deployments){
+        setDeployment(kv.first, kv.second);
+    }
+    orogen.swap(cached_orogen);
+    typekits.swap(cached_typekits);
+    orocosRTTPkg = cached_rtt.isLoaded() ? std::make_shared<PkgConfig>(cached_rtt) : nullptr;
+    return true;
+}
+
+bool orocos_cpp::PkgConfigRegistry::saveCache(const std::string &cacheFile, const std::vector<std::string> &searchPaths)
+{
+    //Write to a temporary file first, so that concurrently starting processes
+    //never read a partially written cache
+    std::string tmpFile = cacheFile + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream os(tmpFile, std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!os.is_open()){
+            return false;
+        }
+
+        write_string(os, cache_magic);
+        write_string(os, make_cache_key(searchPaths));
+        write_uint32(os, deployments.size());
+        for(const auto& kv : deployments){
+            write_string(os, kv.first);
+            kv.second->serialize(os);
+        }
+        write_uint32(os, orogen.size());
+        for(const auto& kv : orogen){
+            write_string(os, kv.first);
+            kv.second->tasks.serialize(os);
+            kv.second->project.serialize(os);
+            kv.second->proxies.serialize(os);
+        }
+        write_uint32(os, typekits.size());
+        for(const auto& kv : typekits){
+            write_string(os, kv.first);
+            kv.second->typekit.serialize(os);
+            write_uint32(os, kv.second->transports.size());
+            for(const auto& transport : kv.second->transports){
+                write_string(os, transport.first);
+                transport.second.serialize(os);
             }
         }
+        (orocosRTTPkg ? *orocosRTTPkg : PkgConfig()).serialize(os);
+        if(!os.good()){
+            os.close();
+            fs::remove(tmpFile);
+            return false;
+        }
+    }
+
+    boost::system::error_code ec;
+    fs::rename(tmpFile, cacheFile, ec);
+    if(ec){
+        fs::remove(tmpFile, ec);
+        return false;
+    }
+    return true;
+}
+
+//inotify file descriptor and the search paths it watches
+struct orocos_cpp::PkgConfigRegistry::FileWatch
+{
+    FileWatch() : fd(-1) {}
+    ~FileWatch()
+    {
+        if(fd >= 0)
+            close(fd);
+    }
+    int fd;
+    //! Maps watch descriptors to search paths
+    std::map<int, std::string> watchedPaths;
+};
+
+bool orocos_cpp::PkgConfigRegistry::watchSearchPaths()
+{
+    boost::unique_lock<boost::shared_mutex> lock(registryMutex);
+    if(fileWatch){
+        return true;
+    }
+
+    std::shared_ptr<FileWatch> watch = std::make_shared<FileWatch>();
+    watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(watch->fd < 0){
+        LOG_ERROR_S << "Could not initialize inotify: " << strerror(errno);
+        return false;
+    }
+    for(const std::string& path : searchPaths){
+        int wd = inotify_add_watch(watch->fd, path.c_str(), IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+        if(wd < 0){
+            LOG_WARN_S << "Could not watch " << path << " for changes: " << strerror(errno);
+            continue;
+        }
+        watch->watchedPaths[wd] = path;
+    }
+    fileWatch = watch;
+    return true;
+}
+
+void orocos_cpp::PkgConfigRegistry::stopWatchingSearchPaths()
+{
+    boost::unique_lock<boost::shared_mutex> lock(registryMutex);
+    fileWatch.reset();
+}
+
+size_t orocos_cpp::PkgConfigRegistry::processSearchPathChanges()
+{
+    boost::unique_lock<boost::shared_mutex> lock(registryMutex);
+    return applySearchPathChanges();
+}
+
+void orocos_cpp::PkgConfigRegistry::pollSearchPathChanges()
+{
+    {
+        boost::shared_lock<boost::shared_mutex> lock(registryMutex);
+        if(!fileWatch){
+            return;
+        }
+        struct pollfd pfd = {fileWatch->fd, POLLIN, 0};
+        if(poll(&pfd, 1, 0) <= 0){
+            return;
+        }
     }
+    boost::unique_lock<boost::shared_mutex> lock(registryMutex);
+    applySearchPathChanges();
 }
 
+size_t orocos_cpp::PkgConfigRegistry::applySearchPathChanges()
+{
+    if(!fileWatch){
+        return 0;
+    }
+
+    //Collect the changed files first, since a file is usually reported
+    //several times (e.g. created and written)
+    std::vector<std::pair<std::string, std::string> > changedFiles;
+    bool overflow = false;
+    char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+    while((len = read(fileWatch->fd, buffer, sizeof(buffer))) > 0){
+        for(char* ptr = buffer; ptr < buffer + len; ptr += sizeof(struct inotify_event) + reinterpret_cast<struct inotify_event*>(ptr)->len){
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+            if(event->mask & IN_Q_OVERFLOW){
+                overflow = true;
+                continue;
+            }
+            std::map<int, std::string>::const_iterator it = fileWatch->watchedPaths.find(event->wd);
+            if(it == fileWatch->watchedPaths.end() || event->len == 0){
+                continue;
+            }
+            std::string dirpath = it->second;
+            while(dirpath.size() > 1 && dirpath[dirpath.size()-1] == '/'){
+                dirpath.resize(dirpath.size()-1);
+            }
+            std::pair<std::string, std::string> file(dirpath, event->name);
+            if(std::find(changedFiles.begin(), changedFiles.end(), file) == changedFiles.end()){
+                changedFiles.push_back(file);
+            }
+        }
+    }
+
+    //Events were dropped by the kernel, the changed files are unknown
+    if(overflow){
+        LOG_WARN_S << "Missed changes of the search paths, rescanning them";
+        return rescanSearchPaths();
+    }
+
+    size_t n_updated = 0;
+    for(const std::pair<std::string, std::string>& file : changedFiles){
+        //Keep the directory index up to date
+        std::map<std::string, DirectoryListing>::iterator dir = directoryIndex.find(file.first);
+        if(dir != directoryIndex.end()){
+            boost::system::error_code ec;
+            if(fs::exists(fs::path(file.first) / file.second, ec)){
+                dir->second.files.insert(file.second);
+            }else{
+                dir->second.files.erase(file.second);
+            }
+        }
+        if(updatePkgFile(file.second)){
+            n_updated++;
+        }
+    }
+    if(!changedFiles.empty()){
+        //Packages that were missing might have been installed
+        missingPackages.clear();
+    }
+    return n_updated;
+}
+
+size_t orocos_cpp::PkgConfigRegistry::rescanSearchPaths()
+{
+    //Files of the loaded packages, to find the removed ones
+    std::set<std::string> filenames;
+    auto add_source = [&filenames](const PkgConfig& pkg){
+        if(pkg.isLoaded()){
+            filenames.insert(fs::path(pkg.sourceFile).filename().string());
+        }
+    };
+    for(const auto& kv : deployments){
+        add_source(*kv.second);
+    }
+    for(const auto& kv : orogen){
+        add_source(kv.second->project);
+        add_source(kv.second->tasks);
+        add_source(kv.second->proxies);
+    }
+    for(const auto& kv : typekits){
+        add_source(kv.second->typekit);
+        for(const auto& transport : kv.second->transports){
+            add_source(transport.second);
+        }
+    }
+    if(orocosRTTPkg){
+        add_source(*orocosRTTPkg);
+    }
+
+    //and the files in the search paths, to find the installed ones
+    directoryIndex.clear();
+    missingPackages.clear();
+    for(const std::string& path : searchPaths){
+        const std::unordered_set<std::string>* files = listDirectory(path);
+        if(files){
+            filenames.insert(files->begin(), files->end());
+        }
+    }
+
+    size_t n_updated = 0;
+    for(const std::string& filename : filenames){
+        if(updatePkgFile(filename)){
+            n_updated++;
+        }
+    }
+    return n_updated;
+}
+
+bool orocos_cpp::PkgConfigRegistry::updatePkgFile(const std::string &filename)
+{
+    std::string name, transportName;
+    PkgKind kind = classifyFile(filename, name, transportName);
+    if(kind == UNKNOWN_PKG){
+        return false;
+    }
+
+    //Packages that were not loaded yet are found by the next lookup
+    bool known = false;
+    switch(kind){
+    case DEPLOYMENT_PKG: known = deployments.count(name); break;
+    case PROXIES_PKG: case OROGEN_PROJECT_PKG: case OROGEN_TASKS_PKG: known = orogen.count(name); break;
+    case TRANSPORT_PKG: case TYPEKIT_PKG: known = typekits.count(name); break;
+    case OROCOS_RTT_PKG: known = bool(orocosRTTPkg); break;
+    default: break;
+    }
+    if(!known && !allPackagesLoaded){
+        return false;
+    }
+
+    //The first search path containing the file describes the package
+    PkgConfig pkg;
+    for(const std::string& path : searchPaths){
+        fs::path filepath = fs::path(path) / filename;
+        boost::system::error_code ec;
+        if(fs::is_regular_file(filepath, ec)){
+            if(!pkg.load(filepath.string())){
+                LOG_ERROR_S << "Error reloading PkgConfig file " << filepath;
+            }
+            break;
+        }
+    }
+    LOG_INFO_S << "PkgConfig file " << filename << (pkg.isLoaded() ? " changed, reloaded it from " + pkg.sourceFile : " was removed");
+
+    //Replace the record, so that records handed out before stay untouched
+    switch(kind){
+    case DEPLOYMENT_PKG:
+        setDeployment(name, pkg.isLoaded() ? std::make_shared<PkgConfig>(pkg) : nullptr);
+        break;
+    case PROXIES_PKG:
+        writable(orogen[name]).proxies = pkg;
+        break;
+    case OROGEN_PROJECT_PKG:
+        writable(orogen[name]).project = pkg;
+        break;
+    case OROGEN_TASKS_PKG:
+        writable(orogen[name]).tasks = pkg;
+        break;
+    case TRANSPORT_PKG:
+        if(pkg.isLoaded())
+            writable(typekits[name]).transports[transportName] = pkg;
+        else
+            writable(typekits[name]).transports.erase(transportName);
+        break;
+    case TYPEKIT_PKG:
+        writable(typekits[name]).typekit = pkg;
+        break;
+    case OROCOS_RTT_PKG:
+        orocosRTTPkg = pkg.isLoaded() ? std::make_shared<PkgConfig>(pkg) : nullptr;
+        break;
+    default:
+        break;
+    }
+
+    //Drop packages of which all files were removed
+    std::map<std::string, std::shared_ptr<OrogenPkgConfig> >::iterator oit = orogen.find(name);
+    if((kind == PROXIES_PKG || kind == OROGEN_PROJECT_PKG || kind == OROGEN_TASKS_PKG) && oit != orogen.end() && !oit->second->project.isLoaded() && !oit->second->tasks.isLoaded() && !oit->second->proxies.isLoaded()){
+        orogen.erase(oit);
+    }
+    std::map<std::string, std::shared_ptr<TypekitPkgConfig> >::iterator tit = typekits.find(name);
+    if((kind == TRANSPORT_PKG || kind == TYPEKIT_PKG) && tit != typekits.end() && !tit->second->typekit.isLoaded() && tit->second->transports.empty()){
+        typekits.erase(tit);
+    }
+    return true;
+}
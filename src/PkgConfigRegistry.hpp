@@ -1,8 +1,14 @@
 #pragma once
 #include <map>
+#include <unordered_set>
+#include <unordered_map>
 #include <vector>
 #include <memory>
+#include <iosfwd>
+#include <chrono>
+#include <atomic>
 #include <boost/filesystem.hpp>
+#include <boost/thread/shared_mutex.hpp>
 
 namespace fs = boost::filesystem;
 
@@ -22,7 +28,7 @@ public:
      * \param value : assigned value of the variable \p variableName will be be retured here
      * \return true of value was successfully read. False if variable was not defined and thus value could net be determined.
      */
-    bool getVariable(const std::string& variableName, std::string& value);
+    bool getVariable(const std::string& variableName, std::string& value) const;
 
     /*!
      * \brief Get value of a property defined within PKGConfig
@@ -38,7 +44,7 @@ public:
      * \param value : assigned value of the property \p propertyName will be be retured here
      * \return true of value was successfully read. False if varibale was not defined and thus value could net be determined.
      */
-    bool getProperty(const std::string& propertyName, std::string& value);
+    bool getProperty(const std::string& propertyName, std::string& value) const;
 
     /*!
      * \brief load and parse a PKGConfig file
@@ -53,12 +59,27 @@ public:
      * \brief Checks wether PKGConfig file has been loaded
      * \return
      */
-    bool isLoaded();
+    bool isLoaded() const;
+
+    //! Write the loaded PKGConfig to a binary stream (used by the
+    //! PkgConfigRegistry cache)
+    void serialize(std::ostream& os) const;
+    //! Restore a PKGConfig that was written with serialize()
+    //! \return false if the stream ended prematurely
+    bool deserialize(std::istream& is);
 
 protected:
-    std::map<std::string, std::string> variables;
-    std::map<std::string, std::string> properties;
+    //! Variables or properties as <name, value>-tuples sorted by name. The
+    //! names are interned: all PkgConfig files share one string instance per
+    //! name, since most files define the same variables (prefix, libdir, ...)
+    typedef std::vector<std::pair<const std::string*, std::string> > Fields;
+    static void assignFields(Fields& fields, const std::map<std::string, std::string>& values);
+    static const std::string* findField(const Fields& fields, const std::string& name);
+
+    Fields variables;
+    Fields properties;
 };
+typedef std::shared_ptr<const PkgConfig> PkgConfigConstPtr;
 
 class TypekitPkgConfig{
 public:
@@ -67,17 +88,34 @@ public:
     std::map<std::string, PkgConfig> transports;
 };
 
+typedef std::shared_ptr<const TypekitPkgConfig> TypekitPkgConfigConstPtr;
+
 class OrogenPkgConfig{
 public:
     PkgConfig tasks;
     PkgConfig project;
     PkgConfig proxies;
 };
+typedef std::shared_ptr<const OrogenPkgConfig> OrogenPkgConfigConstPtr;
+
+//! A task instance deployed by a deployment, as listed in the
+//! 'deployed_tasks_with_models' variable of the deployment's PkgConfig file
+struct DeployedTask
+{
+    std::string deployment;
+    std::string task;
+    //! Task model, e.g. 'rock_runtime_evaluation::MessageConsumer'. Empty if
+    //! the PkgConfig file only lists 'deployed_tasks'.
+    std::string model;
+};
 
 class PkgConfigRegistry;
 typedef std::shared_ptr<PkgConfigRegistry> PkgConfigRegistryPtr;
 extern PkgConfigRegistryPtr __pkgcfgreg;
 
+//! All functions of PkgConfigRegistry can be called concurrently. Lookups
+//! of loaded packages only share a read lock, searching packages that are
+//! not loaded yet locks the registry exclusively.
 class PkgConfigRegistry
 {
 public:
@@ -101,17 +139,37 @@ public:
     //! \param load_all_packages : if \value true, all relevant packages found
     //!                            in search path are loaded. In this case,
     //!                            \var packageNames is ignored.
+    //! \param cacheFile : Only used if \p load_all_packages is \value true.
+    //!                    If not empty, the result of the scan is stored in
+    //!                    this file and reused by later calls as long as the
+    //!                    search paths, their modification times and
+    //!                    OROCOS_TARGET did not change.
+    //! \param scanWorkers : Number of threads used to list the search paths
+    //!                      and parse PkgConfig files if \p load_all_packages
+    //!                      is \value true. 0 uses one thread per core.
     //! \return Pointer to the PkgConfigRegistry. Can be \value nullptr, if
     //!         initialization failed
-    static PkgConfigRegistryPtr initialize(const std::vector<std::string>& packageNames, bool loadAllPackages=false);
+    static PkgConfigRegistryPtr initialize(const std::vector<std::string>& packageNames, bool loadAllPackages=false, const std::string& cacheFile="", unsigned scanWorkers=1);
     //! Retrieve the singleton instance of PkgConfig, that was previously
     //! initialized with PkgConfigRegistry::initialize
     static PkgConfigRegistryPtr get();
 
     //! Avoid using this constructor and use the singleton intialization
     //! instead. \see PkgConfigRegistry::initialize
-    PkgConfigRegistry(const std::vector<std::string>& packageNames, bool loadAllPackages=false);
+    PkgConfigRegistry(const std::vector<std::string>& packageNames, bool loadAllPackages=false, const std::string& cacheFile="", unsigned scanWorkers=1);
+
+    //! Lookup of a package by its name. If the package was not loaded yet and
+    //! \p searchPackageIfNotLoaded is \value true, it is searched in the
+    //! PkgConfig search path.
+    //! The returned records are shared and never modified by the registry,
+    //! so they can be kept without copying them.
+    //! \return The package, or \value nullptr if it could not be found
+    PkgConfigConstPtr getDeployment(const std::string& name, bool searchPackageIfNotLoaded=true);
+    TypekitPkgConfigConstPtr getTypekit(const std::string& name, bool searchPackageIfNotLoaded=true);
+    OrogenPkgConfigConstPtr getOrogen(const std::string& name, bool searchPackageIfNotLoaded=true);
+    PkgConfigConstPtr getOrocosRTT(bool searchPackageIfNotLoaded=true);
 
+    //! Variants of the lookups above, that copy the package to \p pkg
     bool getDeployment(const std::string& name, PkgConfig& pkg, bool searchPackageIfNotLoaded=true);
     bool getTypekit(const std::string& name, TypekitPkgConfig &pkg, bool searchPackageIfNotLoaded=true);
     bool getOrogen(const std::string& name, OrogenPkgConfig& pkg, bool searchPackageIfNotLoaded=true);
@@ -120,9 +178,73 @@ public:
     std::vector<std::string> getRegisteredTypekitNames();
     std::vector<std::string> getRegisteredOrogenNames();
 
+    //! Tasks of the loaded deployments that are instances of the task model
+    //! \p model (e.g. 'foo::Task'), in the order the deployments were loaded.
+    //! Answered from an index, deployments that are not loaded are not
+    //! considered.
+    std::vector<DeployedTask> getDeployedTasksOfModel(const std::string& model);
+    //! Finds the loaded deployment that hosts the task \p taskName
+    //! \return false if no loaded deployment hosts a task with that name
+    bool getDeployedTask(const std::string& taskName, DeployedTask& task);
+    //! All tasks of the loaded deployment \p deploymentName, in the order of
+    //! its PkgConfig file. Empty if the deployment is not loaded.
+    std::vector<DeployedTask> getDeployedTasks(const std::string& deploymentName);
+
+    //! Forget the content of the search paths that was listed by earlier
+    //! lookups. Call this after packages were installed or removed, so
+    //! that lookups of packages that are not loaded yet find them.
+    //! Also forgets missing packages, \see forgetMissingPackages
+    void refreshDirectoryIndex();
+
+    //! Packages that could not be found by a lookup are remembered, so that
+    //! repeated lookups of the same package do not search the search paths
+    //! again. This function forgets these packages.
+    void forgetMissingPackages();
+    //! Let missing packages be searched again \p seconds after they were
+    //! found to be missing. A value <= 0 (default) remembers them until
+    //! forgetMissingPackages is called.
+    void setMissingPackageTTL(double seconds);
+
+    struct LookupStatistics
+    {
+        LookupStatistics() : rescans(0), avoidedRescans(0) {}
+        //! Number of lookups that searched the search paths for a package
+        size_t rescans;
+        //! Number of lookups answered by the remembered missing packages
+        size_t avoidedRescans;
+    };
+    LookupStatistics getLookupStatistics() const;
+
+    //! Watch the search paths for PkgConfig files that are installed,
+    //! changed or removed (e.g. when packages are rebuilt) using inotify.
+    //! Changes are applied by processSearchPathChanges, which is called by
+    //! all lookups, so only the changed files are parsed again.
+    //! Records handed out before a change are not modified.
+    //! \return false if inotify could not be initialized
+    bool watchSearchPaths();
+    void stopWatchingSearchPaths();
+    //! Apply the changes of the watched search paths to the registry.
+    //! Does nothing if the search paths are not watched.
+    //! \return number of packages that were updated
+    size_t processSearchPathChanges();
+
 protected:
+    //! Kinds of packages the registry keeps track of
+    enum PkgKind {
+        UNKNOWN_PKG,
+        DEPLOYMENT_PKG,
+        PROXIES_PKG,
+        OROGEN_PROJECT_PKG,
+        OROGEN_TASKS_PKG,
+        TRANSPORT_PKG,
+        TYPEKIT_PKG,
+        OROCOS_RTT_PKG
+    };
+
     //! To what kind of package a Pkgconfig file is related to is determined by
     //! its filename (NOT path, must be a file name!)
+    //! These functions match a regular expression on each call. Prefer
+    //! classifyFile, which gives the same results in a single pass.
     bool isTransportPkg(const std::string& filename, std::string& typekitName, std::string& transportName, std::string &arch);
     bool isOrogenTasksPkg(const std::string& filename, std::string& orogenProjectName, std::string &arch);
     bool isOrogenProjectPkg(const std::string& filename, std::string& orogenProjectName);
@@ -130,11 +252,27 @@ protected:
     bool isProxiesPkg(const std::string& filename, std::string& orogenProjectName);
     bool isDeploymentPkg(const std::string& filename, std::string& deploymentName);
     bool isOrocosRTTPkg(const std::string &filename, std::string &arch);
+    //! Determines the kind of package from the file name (NOT path). \p name
+    //! is the name of the deployment, orogen project or typekit.
+    //! \p transportName is only set for TRANSPORT_PKG.
+    //! Gives the same result as checking isDeploymentPkg, isProxiesPkg,
+    //! isOrogenProjectPkg, isOrogenTasksPkg, isTransportPkg, isTypekitPkg and
+    //! isOrocosRTTPkg in this order, but scans the file name only once.
+    PkgKind classifyFile(const std::string& filename, std::string& name, std::string& transportName);
+    //! Adds a loaded PkgConfig to the container matching \p kind. The first
+    //! file registered for a package wins, later ones are ignored.
+    //! \return false if \p pkg was ignored
+    bool registerPkg(PkgKind kind, const std::string& name, const std::string& transportName, const PkgConfig& pkg);
 
-    //! [[deprecated(Due to performance issues with the matching of regular
-    //!              expressions this function is now no longer used. Instead
-    //!             'scan' calls 'loadOrogenPkg and loadDeploymentPkg)]]
+    //! Adds, replaces or (if \p pkg is \value nullptr) removes the deployment
+    //! \p name and keeps the task indexes up to date
+    void setDeployment(const std::string& name, PkgConfigConstPtr pkg);
+
+    //! Loads the PkgConfig file \p filepath if its file name identifies a
+    //! package kind known to the registry (\see classifyFile)
     bool addFile(const std::string& filepath);
+    //! Loads the PkgConfig file \p pkg_path into \p pkg, if it exists
+    bool loadPkg(const fs::path &pkg_path, PkgConfig& pkg);
     bool loadOrogenPkg(const fs::path &filepath);
     bool loadDeploymentPkg(const fs::path &filepath);
 
@@ -148,15 +286,94 @@ protected:
     bool loadPackages(const std::vector<std::string> &packageNames, const std::vector<std::string> &searchPaths);
     //! Scans all folders in searchPath for orogen, and Deploment packages and
     //! loads them
-    void loadAllPackages(const std::vector<std::string>& searchPaths);
+    //! If \p nWorkers is not 1, listing folders and parsing files is
+    //! distributed on \p nWorkers threads (0: one per core). Packages are
+    //! registered in search path order afterwards, so the result is the same.
+    void loadAllPackages(const std::vector<std::string>& searchPaths, unsigned nWorkers=1);
+
+    //! Names of all files in \p path. The directory is only listed on the
+    //! first call, later calls are answered from the directory index.
+    //! \return nullptr if \p path is not a directory
+    const std::unordered_set<std::string>* listDirectory(const std::string& path);
+    //! Checks via the directory index, whether \p filepath exists
+    bool hasFile(const fs::path& filepath);
+
+    //! Common implementation of the lookups. \p find returns the package if
+    //! it is loaded and is called with the registry locked.
+    template<typename Ptr, typename Find>
+    Ptr lookup(PkgKind kind, const std::string& name, const char* description, bool searchPackageIfNotLoaded, Find find);
+
+    //! Checks whether the package \p name of \p kind was not found by an
+    //! earlier search, that did not expire yet. Only reads the registry, so
+    //! a shared lock is sufficient.
+    bool isKnownMissing(PkgKind kind, const std::string& name) const;
+    void rememberMissing(PkgKind kind, const std::string& name);
+
+    //! Applies the changes of the watched search paths, if there are any.
+    //! Must be called without holding the lock.
+    void pollSearchPathChanges();
+    //! Implementation of processSearchPathChanges, expects the registry to
+    //! be locked exclusively
+    size_t applySearchPathChanges();
+    //! Lists the search paths again and reloads all files of loaded packages
+    //! and all files found in the search paths. Used when inotify events were
+    //! lost, expects the registry to be locked exclusively.
+    //! \return number of packages that were updated
+    size_t rescanSearchPaths();
+
+    //! Reloads the PkgConfig file \p filename from the first search path
+    //! containing it, or removes it from the registry if no search path
+    //! contains it anymore.
+    //! \return false if the file is not relevant to the registry
+    bool updatePkgFile(const std::string& filename);
+
+    //! Restore the registry from a cache file written by saveCache()
+    //! \return false if the cache file does not exist, is corrupt or was
+    //!         written for different search paths, modification times of
+    //!         the search paths or OROCOS_TARGET
+    bool loadCache(const std::string& cacheFile, const std::vector<std::string>& searchPaths);
+    //! Store the currently registered packages in \p cacheFile
+    bool saveCache(const std::string& cacheFile, const std::vector<std::string>& searchPaths);
 
     //! Containers to store PkgConfig files for different categories of
     //! libraries used in Rock
-    std::map<std::string, PkgConfig> deployments;
-    std::map<std::string, OrogenPkgConfig> orogen;
-    std::map<std::string, TypekitPkgConfig> typekits;
+    //! Records that were handed out by the get* functions must not be
+    //! modified. They are replaced by a modified copy instead.
+    std::map<std::string, PkgConfigConstPtr> deployments;
+    std::map<std::string, std::shared_ptr<OrogenPkgConfig> > orogen;
+    std::map<std::string, std::shared_ptr<TypekitPkgConfig> > typekits;
     //! orocos-rtt library does not fit the other categories above
-    PkgConfig orocosRTTPkg;
+    PkgConfigConstPtr orocosRTTPkg;
+
+    //! Tasks of the loaded deployments by task model and by task name
+    std::unordered_map<std::string, std::vector<DeployedTask> > modelIndex;
+    std::unordered_map<std::string, std::vector<DeployedTask> > taskIndex;
+
+    //! Content of the search paths, see listDirectory
+    struct DirectoryListing
+    {
+        bool valid;
+        std::unordered_set<std::string> files;
+    };
+    std::map<std::string, DirectoryListing> directoryIndex;
+
+    //! Packages that were not found with the time they were searched
+    std::map<std::pair<PkgKind, std::string>, std::chrono::steady_clock::time_point> missingPackages;
+    std::chrono::steady_clock::duration missingPackageTTL;
+    //! Counters of getLookupStatistics, updated without the exclusive lock
+    std::atomic<size_t> nRescans;
+    std::atomic<size_t> nAvoidedRescans;
+
+    //! Search paths given by PKG_CONFIG_PATH at construction
+    std::vector<std::string> searchPaths;
+    //! Whether the registry was initialized with all packages
+    bool allPackagesLoaded;
+    struct FileWatch;
+    std::shared_ptr<FileWatch> fileWatch;
+
+    //! Protects all members above. The protected functions expect the
+    //! caller to hold it.
+    mutable boost::shared_mutex registryMutex;
 };
 
 }
@@ -8,7 +8,19 @@
 #include <base/Time.hpp>
 #include "PkgConfigRegistry.hpp"
 #include "PkgConfigHelper.hpp"
+#include "ParallelFor.hpp"
+#include "TypekitManifest.hpp"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <cstdlib>
 #include <base-logging/Logging.hpp>
 
 #define xstr(s) str(s)
@@ -19,6 +31,45 @@ using namespace orocos_cpp;
     * Cache for the needed typekits.
     */
 std::map<std::string, std::vector<std::string> > PluginHelper::componentToTypeKitsMap;
+std::vector<std::string> PluginHelper::defaultTransports = PluginHelper::getKnownTransports();
+std::map<std::string, std::set<std::string> > PluginHelper::loadedTransports;
+std::vector<std::pair<std::string, PluginHelper::Library> > PluginHelper::loadedLibraries;
+std::map<std::string, std::vector<std::string> > PluginHelper::typekitRequirements;
+
+const std::vector<std::string> &PluginHelper::getKnownTransports()
+{
+    //Supported transport types
+    static const std::vector<std::string> knownTransports = {"corba", "mqueue", "typelib"};
+    return knownTransports;
+}
+
+bool PluginHelper::setDefaultTransports(const std::vector<std::string> &transports)
+{
+    const std::vector<std::string> &known(getKnownTransports());
+    for(const std::string &transport : transports)
+    {
+        if(std::find(known.begin(), known.end(), transport) == known.end())
+        {
+            LOG_ERROR_S << "Unknown transport " << transport;
+            return false;
+        }
+    }
+    defaultTransports = transports;
+    return true;
+}
+
+const std::vector<std::string> &PluginHelper::getDefaultTransports()
+{
+    return defaultTransports;
+}
+
+std::vector<std::string> PluginHelper::getDefaultTransportsWith(const std::string &transport)
+{
+    std::vector<std::string> transports = defaultTransports;
+    if(std::find(transports.begin(), transports.end(), transport) == transports.end())
+        transports.push_back(transport);
+    return transports;
+}
 
 std::vector< std::string > PluginHelper::getNeededTypekits(const std::string& componentName)
 {
@@ -29,28 +80,20 @@ std::vector< std::string > PluginHelper::getNeededTypekits(const std::string& co
 
     PkgConfigRegistryPtr pkgreg = PkgConfigRegistry::get();
 
-    OrogenPkgConfig pkg;
-    if(!pkgreg->getOrogen(componentName, pkg)){
+    OrogenPkgConfigConstPtr pkg = pkgreg->getOrogen(componentName);
+    if(!pkg){
         throw std::runtime_error("Could not load pkgConfig file for typekit for component " + componentName);
     }
     std::string neededTypekitsString;
-    if(!pkg.tasks.getVariable("typekits", neededTypekitsString)){
-        std::cerr << "Tasks-PkgConfig file for component "+ componentName + " ("+pkg.tasks.sourceFile+") is expected to define the 'typekits' variable, but it does not. Trying to load self-named typekit" << std::endl;
+    if(!pkg->tasks.getVariable("typekits", neededTypekitsString)){
+        std::cerr << "Tasks-PkgConfig file for component "+ componentName + " ("+pkg->tasks.sourceFile+") is expected to define the 'typekits' variable, but it does not. Trying to load self-named typekit" << std::endl;
         neededTypekitsString = componentName;
     }
 
     std::vector<std::string> ret = PkgConfigHelper::vectorizeTokenSeparatedString(neededTypekitsString, " ");
-    // Name of orocos-rtt typekit in RTT::types::TypekitRepository is 'rtt-types', but the rock pkg
-    // config files call it as 'orocos'
-    // Result is that RTT::types::TypekitRepository::hasTypekit(tk=orocos) always returns false and
-    // the loading process is triggered
-    // The following loop works around this naming inconsistency
-    //
-    // Note: It is not clear 'why' oroGen generates the tpekit name as 'orocos'. Maybe because of
-    //       orocos.rb specific things? Maybe becausen there was a renaming somewhen in the past?
+    //The PkgConfig files call the RTT typekit 'orocos', see normalizeTypekitName
     for(std::string& tk : ret){
-        if(tk == "orocos")
-            tk = "rtt-types";
+        tk = normalizeTypekitName(tk);
     }
     componentToTypeKitsMap.insert(std::make_pair(componentName, ret));
 
@@ -81,11 +124,11 @@ void PluginHelper::loadAllPluginsInDir(const std::string& path)
     std::cout << "Loaded " << cnt << " typekits in " << (end - start).toSeconds() << " Seconds " << std::endl;
 }
 
-bool PluginHelper::loadAllTypekitAndTransports()
+bool PluginHelper::loadAllTypekitAndTransports(const std::string &pkgConfigCacheFile)
 {
     //Create 'own' PkgconfigRegistry to ensure that all installed packages
     //are loaded.
-    PkgConfigRegistry pkgreg({}, true);
+    PkgConfigRegistry pkgreg({}, true, pkgConfigCacheFile);
     bool all_okay=true;
     for(std::string tk_name : pkgreg.getRegisteredTypekitNames()){
         all_okay &= PluginHelper::loadTypekitAndTransports(tk_name);
@@ -93,89 +136,627 @@ bool PluginHelper::loadAllTypekitAndTransports()
     return all_okay;
 }
 
-bool PluginHelper::loadTypekitAndTransports(const std::string& typekitName)
+bool PluginHelper::isRTTTypekit(const std::string &typekitName)
 {
-    //already loaded, we can just exit
-    if(RTT::types::TypekitRepository::hasTypekit(typekitName)){
-        LOG_DEBUG_S << "Typekit and transport for " << typekitName << " was already laoded earlier";
-        return true;
-    }
-    LOG_INFO_S << "Loading Typekit and Transport for " << typekitName;
+    return typekitName == "rtt-types" || typekitName == "orocos" || typekitName == "rtt";
+}
 
-    //Supported transport types
-    static const std::vector<std::string> knownTransports = {"corba", "mqueue", "typelib"};
+std::string PluginHelper::normalizeTypekitName(const std::string &typekitName)
+{
+    // Name of orocos-rtt typekit in RTT::types::TypekitRepository is 'rtt-types', but the rock pkg
+    // config files call it 'orocos'. Without normalizing,
+    // RTT::types::TypekitRepository::hasTypekit(tk=orocos) always returns false and the
+    // typekit is loaded once per alias
+    //
+    // Note: It is not clear 'why' oroGen generates the tpekit name as 'orocos'. Maybe because of
+    //       orocos.rb specific things? Maybe becausen there was a renaming somewhen in the past?
+    return isRTTTypekit(typekitName) ? "rtt-types" : typekitName;
+}
 
+void PluginHelper::loadRTTTypekits()
+{
+    LOG_DEBUG_S << "Loading RTT typekit";
+    //special case, rtt does not follow the convention of the other typekits
     PkgConfigRegistryPtr pkgreg = PkgConfigRegistry::get();
-    RTT::plugin::PluginLoader &loader(*RTT::plugin::PluginLoader::Instance());
-    PkgConfig pkg;
-    if(typekitName == "rtt-types" || typekitName == "orocos" || typekitName == "rtt")
-    {
-        LOG_DEBUG_S << "Loading RTT typekit";
-        //special case, rtt does not follow the convention below
-        if(!pkgreg->getOrocosRTT(pkg)){
-            throw std::runtime_error("PkgConfig for OROCOS RTT package was not loaded");
-        }
-        std::string libdir;
-        pkg.getVariable("libdir", libdir);
-        if(!loader.loadTypekits(libdir + "/orocos/gnulinux/"))
-            throw std::runtime_error("Error, failed to load rtt basis typekits");
+    PkgConfigConstPtr pkg = pkgreg->getOrocosRTT();
+    if(!pkg){
+        throw std::runtime_error("PkgConfig for OROCOS RTT package was not loaded");
+    }
+    std::string libdir;
+    pkg->getVariable("libdir", libdir);
+    Library library;
+    library.path = libdir + "/orocos/gnulinux/";
+    library.pkgConfigFile = pkg->sourceFile;
+    if(!loadRTTTypekits(library))
+        throw std::runtime_error("Error, failed to load rtt basis typekits and plugins");
+}
 
-        if(!loader.loadPlugins(libdir + "/orocos/gnulinux/"))
-            throw std::runtime_error("Error, failed to load rtt basis plugins");
+bool PluginHelper::loadRTTTypekits(const Library &library)
+{
+    RTT::plugin::PluginLoader &loader(*RTT::plugin::PluginLoader::Instance());
+    if(!loader.loadTypekits(library.path) || !loader.loadPlugins(library.path))
+        return false;
+    loadedLibraries.push_back(std::make_pair(std::string("rtt-types"), library));
+    return true;
+}
 
-        return true;
-    }
+std::vector<PluginHelper::Library> PluginHelper::getTypekitLibraries(const std::string &typekitName)
+{
+    return getTypekitLibraries(typekitName, defaultTransports);
+}
 
-    TypekitPkgConfig tpkg;
-    if(!pkgreg->getTypekit(typekitName, tpkg))
+std::vector<PluginHelper::Library> PluginHelper::getTypekitLibraries(const std::string &typekitName, const std::vector<std::string> &transports)
+{
+    PkgConfigRegistryPtr pkgreg = PkgConfigRegistry::get();
+    TypekitPkgConfigConstPtr tpkg = pkgreg->getTypekit(typekitName);
+    if(!tpkg)
         throw std::runtime_error("No PkgConfig file for typekit of component " + typekitName + " was loaded.");
-    if(!tpkg.typekit.isLoaded()){
+    if(!tpkg->typekit.isLoaded()){
         throw std::runtime_error("No Typekit PkgConfig file for component " + typekitName + " was loaded.");
     }
 
+    std::vector<Library> libraries;
     std::string libDir;
-    tpkg.typekit.getVariable("libdir", libDir);
+    tpkg->typekit.getVariable("libdir", libDir);
 
     //Library of typekit is named after a specific file pattern
-    std::string fname =  libDir + "/lib" + typekitName + "-typekit-" xstr(OROCOS_TARGET) ".so";
-    LOG_DEBUG_S << "Loading typekit from " << fname;
-    if(!loader.loadLibrary(fname))
-        throw std::runtime_error("Error, could not load typekit for component " + typekitName);
+    Library typekit;
+    typekit.path = libDir + "/lib" + typekitName + "-typekit-" xstr(OROCOS_TARGET) ".so";
+    typekit.pkgConfigFile = tpkg->typekit.sourceFile;
+    libraries.push_back(typekit);
 
-    //Load transports for typekit
-    for(const std::string &transport: knownTransports)
+    //Transports for typekit
+    for(const std::string &transport: transports)
     {
-        std::map<std::string, PkgConfig>::iterator it = tpkg.transports.find(transport);
-        if(it == tpkg.transports.end())
+        std::map<std::string, PkgConfig>::const_iterator it = tpkg->transports.find(transport);
+        if(it == tpkg->transports.end())
             throw std::runtime_error("No PkgConfig file was loaded for transport " + transport + " for component " + typekitName);
 
-        pkg = it->second;
+        const PkgConfig& pkg = it->second;
         if(!pkg.getVariable("libdir", libDir)){
             throw(std::runtime_error("PkgConfig file for transport "+transport+"  of typekit "+typekitName+" does not define a 'libdir'."));
         }
 
         //Library of transport for a typekit is named after a specific file pattern
-        fname = libDir + "/lib" + typekitName + "-transport-" + transport + "-" xstr(OROCOS_TARGET) ".so";
-        LOG_DEBUG_S << "Loading typekit from " << fname;
-        if(!loader.loadLibrary(fname))
-            throw std::runtime_error("Error, could not load transport " + transport + " for component " + typekitName);
+        Library library;
+        library.transport = transport;
+        library.path = libDir + "/lib" + typekitName + "-transport-" + transport + "-" xstr(OROCOS_TARGET) ".so";
+        library.pkgConfigFile = pkg.sourceFile;
+        libraries.push_back(library);
+    }
+    return libraries;
+}
+
+void PluginHelper::loadLibraries(const std::string &typekitName, const std::vector<Library> &libraries)
+{
+    RTT::plugin::PluginLoader &loader(*RTT::plugin::PluginLoader::Instance());
+    for(const Library &library : libraries)
+    {
+        LOG_DEBUG_S << "Loading typekit from " << library.path;
+        if(loader.loadLibrary(library.path))
+        {
+            addLoadedLibrary(typekitName, library);
+            continue;
+        }
+        if(library.transport.empty())
+            throw std::runtime_error("Error, could not load typekit for component " + typekitName);
+        throw std::runtime_error("Error, could not load transport " + library.transport + " for component " + typekitName);
+    }
+}
+
+bool PluginHelper::isLibraryLoaded(const std::string &typekitName, const Library &library)
+{
+    if(library.transport.empty())
+        return RTT::types::TypekitRepository::hasTypekit(typekitName);
+    auto it = loadedTransports.find(typekitName);
+    return it != loadedTransports.end() && it->second.count(library.transport);
+}
+
+void PluginHelper::addLoadedLibrary(const std::string &typekitName, const Library &library)
+{
+    std::set<std::string> &transports(loadedTransports[typekitName]);
+    if(!library.transport.empty())
+        transports.insert(library.transport);
+    loadedLibraries.push_back(std::make_pair(typekitName, library));
+}
+
+bool PluginHelper::getMissingLibraries(const std::string &typekitName, const std::vector<std::string> &transports, std::vector<Library> &libraries)
+{
+    const bool typekitLoaded = RTT::types::TypekitRepository::hasTypekit(typekitName);
+    if(isRTTTypekit(typekitName))
+        return !typekitLoaded;
+
+    std::vector<std::string> missingTransports;
+    auto it = loadedTransports.find(typekitName);
+    if(it != loadedTransports.end())
+    {
+        for(const std::string &transport : transports)
+        {
+            if(!it->second.count(transport))
+                missingTransports.push_back(transport);
+        }
+    }
+    else if(!typekitLoaded)
+    {
+        missingTransports = transports;
+    }
+    //else the typekit was loaded elsewhere, e.g. by a deployment, with its transports
+
+    if(typekitLoaded && missingTransports.empty())
+        return false;
+
+    libraries = getTypekitLibraries(typekitName, missingTransports);
+    if(typekitLoaded)
+        libraries.erase(libraries.begin());
+    return true;
+}
+
+void PluginHelper::loadMissingLibraries(const std::string &typekitName, const std::vector<Library> &libraries)
+{
+    LOG_INFO_S << "Loading Typekit and Transport for " << typekitName;
+    if(isRTTTypekit(typekitName))
+        loadRTTTypekits();
+    else
+        loadLibraries(typekitName, libraries);
+}
+
+bool PluginHelper::loadTypekitAndTransports(const std::string& typekitName)
+{
+    return loadTypekitAndTransports(typekitName, defaultTransports);
+}
+
+bool PluginHelper::loadTypekitAndTransports(const std::string& typekitName, const std::vector<std::string> &transports)
+{
+    std::vector<Library> libraries;
+    //already loaded, we can just exit
+    if(!getMissingLibraries(typekitName, transports, libraries)){
+        LOG_DEBUG_S << "Typekit and transport for " << typekitName << " was already laoded earlier";
+        return true;
     }
 
+    loadMissingLibraries(typekitName, libraries);
     return true;
 }
 
+//Reads \p path into the page cache
+static void prefetch_file(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+        return;
+    struct stat st;
+    if(fstat(fd, &st) == 0)
+    {
+        //readahead blocks until the file is read, so the prefetching
+        //threads stay in the order in which the libraries are loaded
+        if(readahead(fd, 0, st.st_size) != 0)
+            posix_fadvise(fd, 0, st.st_size, POSIX_FADV_WILLNEED);
+    }
+    close(fd);
+}
+
+bool PluginHelper::loadTypekitsAndTransports(const std::vector<std::string> &typekitNames, unsigned nPrefetchWorkers)
+{
+    return loadTypekitsAndTransports(typekitNames, nPrefetchWorkers, defaultTransports);
+}
+
+bool PluginHelper::loadTypekitsAndTransports(const std::vector<std::string> &typekitNames, unsigned nPrefetchWorkers, const std::vector<std::string> &transports)
+{
+    bool allOkay = true;
+
+    //Resolve the libraries of all typekits first
+    std::vector<std::pair<std::string, std::vector<Library> > > typekits;
+    std::vector<std::string> files;
+    for(const std::string &typekitName : typekitNames)
+    {
+        std::vector<Library> libraries;
+        try{
+            if(!getMissingLibraries(typekitName, transports, libraries))
+                continue;
+        }catch(std::runtime_error& ex){
+            std::cerr << ex.what() << std::endl;
+            allOkay = false;
+            continue;
+        }
+        for(const Library &library : libraries)
+            files.push_back(library.path);
+        typekits.push_back(std::make_pair(typekitName, libraries));
+    }
+
+    //Prefetch them in the background while loading in order. The prefetcher
+    //is joined on all paths, also if loading throws
+    ScopedThread prefetcher([&](){
+        parallel_for(files.size(), nPrefetchWorkers, [&](size_t i){ prefetch_file(files[i]); });
+    });
+
+    base::Time start = base::Time::now();
+    for(const std::pair<std::string, std::vector<Library> > &typekit : typekits)
+    {
+        try{
+            loadMissingLibraries(typekit.first, typekit.second);
+        }catch(std::runtime_error& ex){
+            std::cerr << ex.what() << std::endl;
+            allOkay = false;
+        }
+    }
+    prefetcher.join();
+    LOG_INFO_S << "Loaded " << typekits.size() << " typekits (" << files.size() << " libraries) in " << (base::Time::now() - start).toSeconds() << " Seconds";
+
+    return allOkay;
+}
+
 bool PluginHelper::loadAllTypekitsForModel(const std::string &modelName){
+    return loadAllTypekitsForModel(modelName, defaultTransports);
+}
+
+bool PluginHelper::loadAllTypekitsForModel(const std::string &modelName, const std::vector<std::string> &transports){
     std::string componentName = modelName.substr(0, modelName.find_first_of(':'));
 
-    std::vector<std::string> neededTks = PluginHelper::getNeededTypekits(componentName);
+    std::vector<std::string> neededTks = getTypekitLoadOrder(PluginHelper::getNeededTypekits(componentName));
     bool retVal = false;
     for(const std::string &tk: neededTks)
     {
-        if(RTT::types::TypekitRepository::hasTypekit(tk))
+        std::vector<Library> libraries;
+        if(!getMissingLibraries(tk, transports, libraries))
             continue;
 
         retVal = true;
-        PluginHelper::loadTypekitAndTransports(tk);
+        loadMissingLibraries(tk, libraries);
     }
     return retVal;
 }
+
+std::vector<std::string> PluginHelper::getRequiredTypekits(const std::string &typekitName)
+{
+    auto it = typekitRequirements.find(typekitName);
+    if(it != typekitRequirements.end())
+        return it->second;
+
+    std::vector<std::string> ret;
+    TypekitPkgConfigConstPtr tpkg;
+    if(!isRTTTypekit(typekitName))
+        tpkg = PkgConfigRegistry::get()->getTypekit(typekitName);
+    std::string requires;
+    if(tpkg && tpkg->typekit.getProperty("Requires", requires))
+    {
+        //e.g. 'base-typekit-gnulinux >= 0.1, orocos-rtt-gnulinux'
+        static const std::string suffix = "-typekit-" xstr(OROCOS_TARGET);
+        for(const std::string &token : PkgConfigHelper::vectorizeTokenSeparatedString(requires, ", \t"))
+        {
+            if(token.size() > suffix.size() && token.compare(token.size() - suffix.size(), suffix.size(), suffix) == 0)
+                ret.push_back(token.substr(0, token.size() - suffix.size()));
+        }
+    }
+    typekitRequirements.insert(std::make_pair(typekitName, ret));
+    return ret;
+}
+
+std::vector<std::string> PluginHelper::getTypekitLoadOrder(const std::vector<std::string> &typekitNames)
+{
+    std::vector<std::string> order;
+
+    //Depth first search, a typekit is added after all typekits it requires
+    std::set<std::string> visited;
+    std::set<std::string> onStack;
+    std::function<void(const std::string&)> visit = [&](const std::string &name){
+        const std::string typekitName = normalizeTypekitName(name);
+        if(visited.count(typekitName))
+            return;
+        if(onStack.count(typekitName)){
+            LOG_WARN_S << "Typekit " << typekitName << " requires itself through other typekits";
+            return;
+        }
+        onStack.insert(typekitName);
+        for(const std::string &required : getRequiredTypekits(typekitName))
+            visit(required);
+        onStack.erase(typekitName);
+        visited.insert(typekitName);
+        order.push_back(typekitName);
+    };
+    for(const std::string &typekitName : typekitNames)
+        visit(typekitName);
+
+    return order;
+}
+
+bool PluginHelper::isTypekitLoaded(const std::string &typekitName, const std::vector<std::string> &transports)
+{
+    if(!RTT::types::TypekitRepository::hasTypekit(typekitName))
+        return false;
+    auto it = loadedTransports.find(typekitName);
+    //the RTT typekit and typekits loaded elsewhere, e.g. by a deployment,
+    //come with their transports
+    if(isRTTTypekit(typekitName) || it == loadedTransports.end())
+        return true;
+    for(const std::string &transport : transports)
+    {
+        if(!it->second.count(transport))
+            return false;
+    }
+    return true;
+}
+
+PluginHelper::TypekitLoadPlan PluginHelper::getTypekitLoadPlan(const std::vector<std::string> &typekitNames)
+{
+    return getTypekitLoadPlan(typekitNames, defaultTransports);
+}
+
+PluginHelper::TypekitLoadPlan PluginHelper::getTypekitLoadPlan(const std::vector<std::string> &typekitNames, const std::vector<std::string> &transports)
+{
+    base::Time start = base::Time::now();
+    TypekitLoadPlan plan;
+    plan.transports = transports;
+    for(const std::string &typekitName : getTypekitLoadOrder(typekitNames))
+    {
+        if(!isTypekitLoaded(typekitName, transports))
+            plan.typekits.push_back(typekitName);
+    }
+    plan.resolveSeconds = (base::Time::now() - start).toSeconds();
+    return plan;
+}
+
+PluginHelper::TypekitLoadPlan PluginHelper::getTypekitLoadPlanForModels(const std::vector<std::string> &modelNames)
+{
+    std::vector<std::string> typekitNames;
+    for(const std::string &modelName : modelNames)
+    {
+        std::string componentName = modelName.substr(0, modelName.find_first_of(':'));
+        std::vector<std::string> neededTks = getNeededTypekits(componentName);
+        typekitNames.insert(typekitNames.end(), neededTks.begin(), neededTks.end());
+    }
+    return getTypekitLoadPlan(typekitNames);
+}
+
+bool PluginHelper::loadTypekits(TypekitLoadPlan &plan, unsigned nPrefetchWorkers)
+{
+    base::Time start = base::Time::now();
+    bool allOkay = loadTypekitsAndTransports(plan.typekits, nPrefetchWorkers, plan.transports);
+    plan.loadSeconds = (base::Time::now() - start).toSeconds();
+    return allOkay;
+}
+
+bool PluginHelper::saveTypekitManifest(const std::string &manifestFile, const std::string &key)
+{
+    std::vector<TypekitManifest::Entry> entries;
+    for(const std::pair<std::string, Library> &loaded : loadedLibraries)
+    {
+        TypekitManifest::Entry entry;
+        entry.typekit = loaded.first;
+        entry.transport = loaded.second.transport;
+        entry.path = loaded.second.path;
+        entry.pkgConfigFile = loaded.second.pkgConfigFile;
+        entries.push_back(entry);
+    }
+    return TypekitManifest::save(manifestFile, key, entries);
+}
+
+bool PluginHelper::replayTypekitManifest(const std::string &manifestFile, const std::string &key, unsigned nPrefetchWorkers)
+{
+    std::vector<TypekitManifest::Entry> entries;
+    switch(TypekitManifest::load(manifestFile, key, entries))
+    {
+        case TypekitManifest::VALID:
+            break;
+        case TypekitManifest::MISSING:
+            LOG_INFO_S << "Typekit manifest " << manifestFile << " does not exist";
+            return false;
+        case TypekitManifest::OTHER_KEY:
+            LOG_INFO_S << "Typekit manifest " << manifestFile << " was written for other transports or packages";
+            return false;
+        case TypekitManifest::CORRUPT:
+            LOG_WARN_S << "Typekit manifest " << manifestFile << " is corrupt";
+            return false;
+        case TypekitManifest::OUTDATED:
+            LOG_INFO_S << "Typekit manifest " << manifestFile << " is outdated, a library or PkgConfig file changed";
+            return false;
+    }
+
+    std::vector<std::pair<std::string, Library> > libraries;
+    std::vector<std::string> files;
+    for(const TypekitManifest::Entry &entry : entries)
+    {
+        Library library;
+        library.transport = entry.transport;
+        library.path = entry.path;
+        library.pkgConfigFile = entry.pkgConfigFile;
+        if(!isRTTTypekit(entry.typekit))
+            files.push_back(library.path);
+        libraries.push_back(std::make_pair(entry.typekit, library));
+    }
+
+    ScopedThread prefetcher([&](){
+        parallel_for(files.size(), nPrefetchWorkers, [&](size_t i){ prefetch_file(files[i]); });
+    });
+
+    base::Time start = base::Time::now();
+    RTT::plugin::PluginLoader &loader(*RTT::plugin::PluginLoader::Instance());
+    bool allOkay = true;
+    for(const std::pair<std::string, Library> &entry : libraries)
+    {
+        const std::string &typekitName(entry.first);
+        const Library &library(entry.second);
+        if(isRTTTypekit(typekitName))
+        {
+            if(!RTT::types::TypekitRepository::hasTypekit(typekitName) && !loadRTTTypekits(library))
+            {
+                allOkay = false;
+                break;
+            }
+            continue;
+        }
+
+        if(isLibraryLoaded(typekitName, library))
+            continue;
+
+        LOG_DEBUG_S << "Loading typekit from " << library.path;
+        if(!loader.loadLibrary(library.path))
+        {
+            allOkay = false;
+            break;
+        }
+        addLoadedLibrary(typekitName, library);
+    }
+    prefetcher.join();
+
+    if(!allOkay)
+    {
+        LOG_WARN_S << "Could not load all libraries listed in typekit manifest " << manifestFile;
+        return false;
+    }
+    LOG_INFO_S << "Loaded " << libraries.size() << " libraries from typekit manifest " << manifestFile << " in " << (base::Time::now() - start).toSeconds() << " Seconds";
+    return true;
+}
+
+//Manifest that lists the libraries of a typekit bundle, with the stamps
+//that tell whether the bundle is still valid
+static std::string bundle_manifest_file(const std::string &bundleFile)
+{
+    return bundleFile + ".manifest";
+}
+
+static std::string to_shell_argument(const std::string &s)
+{
+    std::string ret = "'";
+    for(char c : s)
+    {
+        if(c == '\'')
+            ret += "'\\''";
+        else
+            ret += c;
+    }
+    return ret + "'";
+}
+
+bool PluginHelper::buildTypekitBundle(const std::string &bundleFile, const std::vector<std::string> &typekitNames, const std::string &compiler)
+{
+    std::vector<TypekitManifest::Entry> entries;
+    for(const std::string &typekitName : getTypekitLoadOrder(typekitNames))
+    {
+        if(isRTTTypekit(typekitName))
+            continue;
+        try{
+            for(const Library &library : getTypekitLibraries(typekitName))
+            {
+                TypekitManifest::Entry entry;
+                entry.typekit = typekitName;
+                entry.transport = library.transport;
+                entry.path = library.path;
+                entry.pkgConfigFile = library.pkgConfigFile;
+                entries.push_back(entry);
+            }
+        }catch(std::runtime_error& ex){
+            std::cerr << ex.what() << std::endl;
+            return false;
+        }
+    }
+
+    //The bundle has no code of its own, it only depends on the libraries
+    std::string sourceFile = bundleFile + ".cpp";
+    {
+        std::ofstream os(sourceFile, std::ios::out | std::ios::trunc);
+        if(!os.is_open())
+            return false;
+        os << "//Typekit bundle, see orocos_cpp::PluginHelper::buildTypekitBundle\n";
+        if(!os.good())
+            return false;
+    }
+
+    //Link against all libraries, so that the dynamic linker loads them
+    //with the bundle. The rpath is searched before LD_LIBRARY_PATH, so the
+    //libraries are found where the manifest says they are.
+    std::string command = compiler + " -shared -fPIC -o " + to_shell_argument(bundleFile) + " " + to_shell_argument(sourceFile) +
+                          " -Wl,--no-as-needed -Wl,--disable-new-dtags";
+    std::set<std::string> libDirs;
+    for(const TypekitManifest::Entry &entry : entries)
+    {
+        command += " " + to_shell_argument(entry.path);
+        libDirs.insert(boost::filesystem::path(entry.path).parent_path().string());
+    }
+    for(const std::string &libDir : libDirs)
+        command += " -Wl,-rpath," + to_shell_argument(libDir);
+
+    LOG_INFO_S << "Building typekit bundle " << bundleFile << " from " << entries.size() << " libraries";
+    const bool built = std::system(command.c_str()) == 0;
+    boost::system::error_code ec;
+    boost::filesystem::remove(sourceFile, ec);
+    if(!built)
+    {
+        std::cerr << "Error, could not build typekit bundle " << bundleFile << std::endl;
+        return false;
+    }
+
+    //The manifest is keyed on the built bundle, so a bundle that is rebuilt
+    //without it is never loaded with stale contents
+    if(!TypekitManifest::save(bundle_manifest_file(bundleFile), TypekitManifest::makeBundleKey(bundleFile), entries))
+    {
+        std::cerr << "Error, could not write manifest of typekit bundle " << bundleFile << std::endl;
+        boost::filesystem::remove(bundleFile, ec);
+        return false;
+    }
+    return true;
+}
+
+bool PluginHelper::loadTypekitBundle(const std::string &bundleFile)
+{
+    //A bundle finds its libraries through its rpath. If a typekit was
+    //rebuilt, reinstalled or removed since the bundle was built, the bundle
+    //would load the old library, and the typekit would not be loaded from
+    //its current location afterwards as it counts as loaded. So the bundle
+    //is only used if none of its libraries changed.
+    const std::string manifestFile = bundle_manifest_file(bundleFile);
+    std::vector<TypekitManifest::Entry> entries;
+    switch(TypekitManifest::load(manifestFile, TypekitManifest::makeBundleKey(bundleFile), entries))
+    {
+        case TypekitManifest::VALID:
+            break;
+        case TypekitManifest::MISSING:
+            LOG_WARN_S << "Typekit bundle " << bundleFile << " has no manifest " << manifestFile;
+            return false;
+        case TypekitManifest::OTHER_KEY:
+            LOG_WARN_S << "Typekit bundle " << bundleFile << " was rebuilt or the PKG_CONFIG_PATH changed, rebuild it";
+            return false;
+        case TypekitManifest::CORRUPT:
+            LOG_WARN_S << "Manifest " << manifestFile << " of typekit bundle " << bundleFile << " is corrupt";
+            return false;
+        case TypekitManifest::OUTDATED:
+            LOG_WARN_S << "Typekit bundle " << bundleFile << " is outdated, a library or PkgConfig file changed, rebuild it";
+            return false;
+    }
+
+    base::Time start = base::Time::now();
+    void *bundle = dlopen(bundleFile.c_str(), RTLD_NOW | RTLD_GLOBAL);
+    if(!bundle)
+    {
+        LOG_WARN_S << "Could not load typekit bundle " << bundleFile << ": " << dlerror();
+        return false;
+    }
+
+    //The dynamic linker mapped and relocated each library on its own. Each
+    //one is still registered through the PluginLoader, which only takes
+    //another reference when opening it again, and runs its registration
+    //entry point. This also lets later loadLibrary or loadTypekits calls
+    //skip it.
+    RTT::plugin::PluginLoader &loader(*RTT::plugin::PluginLoader::Instance());
+    bool allOkay = true;
+    size_t cnt = 0;
+    for(const TypekitManifest::Entry &entry : entries)
+    {
+        Library library;
+        library.transport = entry.transport;
+        library.path = entry.path;
+        library.pkgConfigFile = entry.pkgConfigFile;
+        if(isLibraryLoaded(entry.typekit, library))
+            continue;
+
+        if(!loader.loadLibrary(library.path))
+        {
+            std::cerr << "Error, could not register " << library.path << " from typekit bundle " << bundleFile << std::endl;
+            allOkay = false;
+            continue;
+        }
+        addLoadedLibrary(entry.typekit, library);
+        cnt++;
+    }
+    LOG_INFO_S << "Loaded " << cnt << " libraries from typekit bundle " << bundleFile << " in " << (base::Time::now() - start).toSeconds() << " Seconds";
+    return allOkay;
+}
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <map>
+#include <set>
 #include <string>
 #include "PkgConfigRegistry.hpp"
 
@@ -12,16 +13,106 @@ class PluginHelper
 {
 private:
     static std::map<std::string, std::vector<std::string> > componentToTypeKitsMap;
+    static std::vector<std::string> defaultTransports;
+    //! Transports loaded by PluginHelper, by typekit name
+    static std::map<std::string, std::set<std::string> > loadedTransports;
+    //! Cache of getRequiredTypekits
+    static std::map<std::string, std::vector<std::string> > typekitRequirements;
+
+    //! True if \p typekitName is loaded with all of \p transports
+    static bool isTypekitLoaded(const std::string &typekitName, const std::vector<std::string> &transports);
+
+    //! \p typekitNames and the typekits they require, each one after its
+    //! requirements. Aliases of the RTT typekit are listed as rtt-types.
+    static std::vector<std::string> getTypekitLoadOrder(const std::vector<std::string> &typekitNames);
     
 public:
+    //! Shared library of a typekit or of one of its transports
+    struct Library
+    {
+        //! Transport the library provides, empty for the typekit itself
+        std::string transport;
+        std::string path;
+        //! PkgConfig file the library was resolved from, empty if unknown
+        std::string pkgConfigFile;
+    };
+
+    /**
+     * Typekits in the order in which they have to be loaded,
+     * see getTypekitLoadPlan
+     * */
+    struct TypekitLoadPlan
+    {
+        TypekitLoadPlan() : resolveSeconds(0), loadSeconds(0) {}
+        //! Typekits to load, each one after the typekits it requires
+        std::vector<std::string> typekits;
+        //! Transports to load with the typekits
+        std::vector<std::string> transports;
+        //! Time spent by getTypekitLoadPlan
+        double resolveSeconds;
+        //! Time spent by loadTypekits, 0 if the plan was not loaded yet
+        double loadSeconds;
+    };
+
     static void loadAllPluginsInDir(const std::string &path);
 
-    static bool loadAllTypekitAndTransports();
+    //! Transports that typekits can provide: corba, mqueue and typelib
+    static const std::vector<std::string> &getKnownTransports();
+
+    /**
+     * Sets the transports that are loaded with a typekit if the caller
+     * does not ask for specific transports. By default all known transports.
+     * Other transports are loaded on demand, when a function is called with
+     * a transport that was not loaded for a typekit before, e.g. typelib by
+     * ConfigurationHelper::applyConfig.
+     * @return false if \p transports contains a transport that is not
+     *         known, the default transports are left unchanged then
+     * */
+    static bool setDefaultTransports(const std::vector<std::string> &transports);
+    static const std::vector<std::string> &getDefaultTransports();
+    //! The default transports plus \p transport, for callers that need a
+    //! transport which might not be loaded by default
+    static std::vector<std::string> getDefaultTransportsWith(const std::string &transport);
+
+    /**
+     * Loads the typekits and transports of all installed packages.
+     * @param pkgConfigCacheFile If not empty, the scan for installed packages
+     *        is cached in this file. \see PkgConfigRegistry::initialize
+     * */
+    static bool loadAllTypekitAndTransports(const std::string &pkgConfigCacheFile="");
     /**
      * This function loads the typekits and transports of the given
      * component.
      * */
     static bool loadTypekitAndTransports(const std::string &typekitName);
+    /**
+     * Loads the typekit of the given component and the given \p transports.
+     * If the typekit was loaded before, only the missing transports are
+     * loaded. Typekits that were not loaded by PluginHelper are expected to
+     * come with their transports.
+     * */
+    static bool loadTypekitAndTransports(const std::string &typekitName, const std::vector<std::string> &transports);
+
+    /**
+     * Loads the typekits and transports of \p typekitNames, in this order.
+     * The paths of all libraries are resolved first. While the libraries are
+     * loaded one after another, \p nPrefetchWorkers threads (0: one per
+     * core) read them ahead into the page cache, so that loading does not
+     * wait for the disk on a cold start.
+     * Errors are reported, and the remaining typekits are loaded anyway.
+     * @return false if any typekit could not be loaded
+     * */
+    static bool loadTypekitsAndTransports(const std::vector<std::string> &typekitNames, unsigned nPrefetchWorkers=1);
+    static bool loadTypekitsAndTransports(const std::vector<std::string> &typekitNames, unsigned nPrefetchWorkers, const std::vector<std::string> &transports);
+
+    /**
+     * Resolves the paths of the libraries of a typekit and its transports,
+     * in the order in which they have to be loaded.
+     * Not supported for the RTT typekit, which is loaded from a folder.
+     * @throws std::runtime_error if a PkgConfig file is missing
+     * */
+    static std::vector<Library> getTypekitLibraries(const std::string &typekitName);
+    static std::vector<Library> getTypekitLibraries(const std::string &typekitName, const std::vector<std::string> &transports);
 
     /**
      * This method loads all typkits required for a task model.
@@ -35,14 +126,121 @@ public:
      * @throws std::runtime_error if errors during loading of a typekit occur
      */
     static bool loadAllTypekitsForModel(const std::string &modelName);
+    static bool loadAllTypekitsForModel(const std::string &modelName, const std::vector<std::string> &transports);
 
     /**
      * This function parses the local pkg_config file to
      * figure out which typkits are need by the given component.
+     * The RTT typekit is returned as 'rtt-types', which is its name in
+     * RTT::types::TypekitRepository, even though the PkgConfig files call it
+     * 'orocos'.
      * 
      * @return A vector containing the names of the needed typekits
      * */
     static std::vector<std::string> getNeededTypekits(const std::string &componentName);
+
+    /**
+     * Returns the typekits a typekit requires directly, as given by the
+     * 'Requires' field of its PkgConfig file.
+     * */
+    static std::vector<std::string> getRequiredTypekits(const std::string &typekitName);
+
+    /**
+     * Resolves \p typekitNames (e.g. from getNeededTypekits or
+     * Deployment::getNeededTypekits) and all typekits they require into a
+     * single plan without duplicates, in which every typekit comes after the
+     * typekits it requires. Typekits that are loaded already with all of
+     * \p transports (default: the default transports) are left out.
+     * */
+    static TypekitLoadPlan getTypekitLoadPlan(const std::vector<std::string> &typekitNames);
+    static TypekitLoadPlan getTypekitLoadPlan(const std::vector<std::string> &typekitNames, const std::vector<std::string> &transports);
+    //! Load plan for the typekits needed by task models, e.g. "camera_usb::Task"
+    static TypekitLoadPlan getTypekitLoadPlanForModels(const std::vector<std::string> &modelNames);
+
+    /**
+     * Loads the typekits of \p plan with the transports of the plan, see
+     * loadTypekitsAndTransports, and stores the time it took in the plan.
+     * @return false if any typekit could not be loaded
+     * */
+    static bool loadTypekits(TypekitLoadPlan &plan, unsigned nPrefetchWorkers=1);
+
+    /**
+     * Writes the paths of all libraries loaded by PluginHelper so far, in
+     * load order, to a manifest file, together with the stamps of the
+     * libraries and of their PkgConfig files. \p key states what the
+     * manifest is valid for, see TypekitManifest::makeKey.
+     * @return false if the file could not be written
+     * */
+    static bool saveTypekitManifest(const std::string &manifestFile, const std::string &key);
+
+    /**
+     * Loads the libraries listed in a manifest written by
+     * saveTypekitManifest, without resolving their paths through the
+     * PkgConfigRegistry, which therefore does not need to be initialized.
+     * Libraries are prefetched like in loadTypekitsAndTransports.
+     * @return false if the manifest does not exist, was written with another
+     *         \p key, lists a library or PkgConfig file that changed since,
+     *         or a library could not be loaded. The typekits have to be
+     *         loaded the normal way then, libraries that were loaded from
+     *         the manifest are not loaded again.
+     * */
+    static bool replayTypekitManifest(const std::string &manifestFile, const std::string &key, unsigned nPrefetchWorkers=1);
+
+    /**
+     * Builds a typekit bundle: an empty shared object that depends on the
+     * libraries of \p typekitNames, the typekits they require and the default
+     * transports. Rock installs these only as shared objects, so they cannot
+     * be relinked into one object with a combined registration entry point.
+     * A manifest next to the bundle (\p bundleFile + ".manifest") lists the
+     * libraries in load order, with stamps of them and their PkgConfig
+     * files, see TypekitManifest::makeBundleKey.
+     * The RTT typekit is not part of a bundle, as it is loaded from a folder.
+     * The bundle is linked with \p compiler from a generated source file
+     * next to \p bundleFile, which is removed afterwards.
+     * @return false if the libraries could not be resolved or the bundle or
+     *         its manifest could not be written
+     * */
+    static bool buildTypekitBundle(const std::string &bundleFile, const std::vector<std::string> &typekitNames, const std::string &compiler="c++");
+
+    /**
+     * Loads a bundle written by buildTypekitBundle, if none of its libraries
+     * and PkgConfig files changed since it was built. The dynamic linker
+     * loads the libraries as dependencies of the bundle, but still maps and
+     * relocates each of them separately. Afterwards each library is
+     * registered with RTT's PluginLoader in the order of the manifest, which
+     * runs its registration entry point. Compared to loadTypekits, only
+     * resolving the libraries through the PkgConfig files is saved, like
+     * with a typekit manifest. Libraries that were loaded before are
+     * skipped. Typekits that are not in the bundle can be loaded the normal
+     * way afterwards.
+     * @return false if the bundle is outdated, could not be loaded, or a
+     *         library in it could not be registered
+     * */
+    static bool loadTypekitBundle(const std::string &bundleFile);
+
+private:
+    //! Libraries loaded by PluginHelper in load order, with their typekit.
+    //! For the RTT typekit, the path is the folder it was loaded from.
+    static std::vector<std::pair<std::string, Library> > loadedLibraries;
+
+    static bool isRTTTypekit(const std::string &typekitName);
+    //! 'rtt-types' for the aliases of the RTT typekit, \p typekitName otherwise
+    static std::string normalizeTypekitName(const std::string &typekitName);
+    static void loadRTTTypekits();
+    static bool loadRTTTypekits(const Library &library);
+    static void loadLibraries(const std::string &typekitName, const std::vector<Library> &libraries);
+    static bool isLibraryLoaded(const std::string &typekitName, const Library &library);
+    //! Records a library that was loaded, see loadedLibraries and loadedTransports
+    static void addLoadedLibrary(const std::string &typekitName, const Library &library);
+
+    /**
+     * Resolves the libraries of a typekit and of those of \p transports,
+     * which were not loaded yet. For the RTT typekit, \p libraries stays
+     * empty.
+     * @return false if nothing needs to be loaded
+     * */
+    static bool getMissingLibraries(const std::string &typekitName, const std::vector<std::string> &transports, std::vector<Library> &libraries);
+    static void loadMissingLibraries(const std::string &typekitName, const std::vector<Library> &libraries);
 };
 }//end of namespace
 
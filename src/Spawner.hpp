@@ -60,6 +60,12 @@ public:
      * If a third argument is given, the task text logs will be redirected to the bundle log folder.
      * The method will throw if any error occures.
      * 
+     * The default deployment of the model (orogen_default_*) is used if it
+     * is installed. Otherwise a loaded deployment providing the model is
+     * used, but only if it is the only one and hosts no other task besides
+     * its logger. If there is no such deployment, the method throws and
+     * lists the candidate deployments.
+     * 
      * @arg cmp1 The task model name e.g Hokuyo::Task 
      * @arg as The name unter wich the taskmodel should be registered a the nameservice
      * @arg redirectOutput flag about whether the deployment text log files should be redirected
@@ -0,0 +1,88 @@
+#include "TypeNameIndex.hpp"
+#include <cstring>
+
+namespace orocos_cpp
+{
+
+TypeNameIndex::TypeNameIndex() : slots(64, 0)
+{
+}
+
+uint32_t TypeNameIndex::hash(const char *name, size_t length)
+{
+    //FNV-1a
+    uint32_t h = 2166136261u;
+    for(size_t i = 0; i < length; i++){
+        h ^= static_cast<unsigned char>(name[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+size_t TypeNameIndex::findSlot(const char *name, size_t length, uint32_t hash) const
+{
+    const size_t mask = slots.size() - 1;
+    for(size_t slot = hash & mask; ; slot = (slot + 1) & mask){
+        if(slots[slot] == 0)
+            return slot;
+        const Entry& entry = entries[slots[slot] - 1];
+        if(entry.hash == hash && entry.length == length &&
+           (length == 0 || memcmp(names.data() + entry.offset, name, length) == 0))
+            return slot;
+    }
+}
+
+void TypeNameIndex::grow()
+{
+    std::vector<uint32_t>(slots.size() * 2, 0).swap(slots);
+    const size_t mask = slots.size() - 1;
+    for(size_t i = 0; i < entries.size(); i++){
+        size_t slot = entries[i].hash & mask;
+        while(slots[slot] != 0)
+            slot = (slot + 1) & mask;
+        slots[slot] = i + 1;
+    }
+}
+
+bool TypeNameIndex::insert(const char *name, size_t length, unsigned value)
+{
+    const uint32_t h = hash(name, length);
+    size_t slot = findSlot(name, length, h);
+    if(slots[slot] != 0)
+        return false;
+
+    Entry entry;
+    entry.offset = names.size();
+    entry.length = length;
+    entry.hash = h;
+    entry.value = value;
+    names.insert(names.end(), name, name + length);
+    entries.push_back(entry);
+    slots[slot] = entries.size();
+
+    //Keep the load factor below 1/2
+    if(entries.size() * 2 > slots.size())
+        grow();
+    return true;
+}
+
+bool TypeNameIndex::insert(const std::string &name, unsigned value)
+{
+    return insert(name.data(), name.size(), value);
+}
+
+bool TypeNameIndex::find(const std::string &name, unsigned &value) const
+{
+    size_t slot = findSlot(name.data(), name.size(), hash(name.data(), name.size()));
+    if(slots[slot] == 0)
+        return false;
+    value = entries[slots[slot] - 1].value;
+    return true;
+}
+
+size_t TypeNameIndex::size() const
+{
+    return entries.size();
+}
+
+}
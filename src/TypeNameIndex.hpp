@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace orocos_cpp
+{
+
+/*!
+ * \brief Compact map from type names to small integers, e.g. typekit IDs
+ *
+ * The names are stored back to back in a single buffer and the hash table
+ * only holds indices into it. An entry costs the length of its name, a
+ * 16 byte Entry and two to four 4 byte slots, as the table is kept at most
+ * half full, i.e. 24 to 32 bytes plus the spare capacity of the vectors.
+ * It does not need an allocation of its own, which matters for the tens
+ * of thousands of types listed in the typelist files.
+ */
+class TypeNameIndex
+{
+public:
+    TypeNameIndex();
+
+    //! Adds \p name with \p value, unless \p name is already present
+    //! \return false if \p name was present before
+    bool insert(const char* name, size_t length, unsigned value);
+    bool insert(const std::string& name, unsigned value);
+
+    //! \return false if \p name is not present
+    bool find(const std::string& name, unsigned& value) const;
+
+    size_t size() const;
+
+    //! Calls \p f(name, value) for all entries, in the order they were added
+    template<typename F>
+    void forEach(const F& f) const
+    {
+        for(const Entry& entry : entries){
+            f(std::string(names.data() + entry.offset, entry.length), entry.value);
+        }
+    }
+
+private:
+    struct Entry
+    {
+        uint32_t offset;
+        uint32_t length;
+        uint32_t hash;
+        uint32_t value;
+    };
+
+    static uint32_t hash(const char* name, size_t length);
+    //! \return the slot holding \p name, or the empty slot where it belongs
+    size_t findSlot(const char* name, size_t length, uint32_t hash) const;
+    void grow();
+
+    std::vector<char> names;
+    std::vector<Entry> entries;
+    //! Open addressing table of indices into \var entries plus one, 0 is empty
+    std::vector<uint32_t> slots;
+};
+
+}
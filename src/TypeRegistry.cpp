@@ -3,24 +3,35 @@
 #include <boost/algorithm/string.hpp>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <cstring>
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <typelib/registry.hh>
 #include <typelib/registryiterator.hh>
 #include <typelib/pluginmanager.hh>
 #include <typelib/typemodel.hh>
 #include <typelib/importer.hh>
+#include <utilmm/configfile/configset.hh>
 #include "PkgConfigRegistry.hpp"
+#include "ParallelFor.hpp"
 #include <base-logging/Logging.hpp>
 
 namespace orocos_cpp 
 {
 
 TypeRegistry::TypeRegistry(PkgConfigRegistryPtr pkgreg) :
-    pkgreg(pkgreg), registry(new Typelib::Registry())
+    pkgreg(pkgreg), registry(new Typelib::Registry()), lazyLoading(false)
 {
-    typeToTypekit.insert(std::make_pair("int", "rtt-types"));
-    typeToTypekit.insert(std::make_pair("bool", "rtt-types"));
-    typeToTypekit.insert(std::make_pair("string", "rtt-types"));
-    typeToTypekit.insert(std::make_pair("double", "rtt-types"));
+    unsigned rttTypes = internTypekitName("rtt-types");
+    typeToTypekit.insert("int", rttTypes);
+    typeToTypekit.insert("bool", rttTypes);
+    typeToTypekit.insert("string", rttTypes);
+    typeToTypekit.insert("double", rttTypes);
 }
 
 TypeRegistry::TypeRegistry() : TypeRegistry(PkgConfigRegistry::get())
@@ -34,15 +45,8 @@ bool TypeRegistry::loadTypeRegistry(const std::string& typekitName, bool force)
     }
 
     //Resolve bath to TLB file
-    TypekitPkgConfig tpkg;
-    if(!pkgreg->getTypekit(typekitName, tpkg)){
-        LOG_ERROR_S << "Could not retrieve Tpekit from PkgConfigRegistry";
-        return false;
-    }
-
     std::string typeRegistryPath;
-    if(!tpkg.typekit.getVariable("type_registry", typeRegistryPath)){
-        LOG_INFO_S << "PkgConfig file of typekit " << typekitName << " does not specify the type_registry variable";
+    if(!getTypeRegistryPath(typekitName, typeRegistryPath)){
         return false;
     }
 
@@ -53,152 +57,891 @@ bool TypeRegistry::loadTypeRegistry(const std::string& typekitName, bool force)
         LOG_ERROR_S << "Could not load tlb path: " << typeRegistryPath;
         return false;
     }
+    return loadTypekitIndexes(typekitName, typeRegistryPath);
+}
 
+bool TypeRegistry::loadTypekitIndexes(const std::string &typekitName, std::string typeRegistryPath)
+{
     // Load any states from the tlb to taskStateToID;
-    if (!loadStateToIDMapping(typeRegistryPath))
+    if (!loadImportedStateTables())
     {
-        LOG_ERROR_S << "Could not parse Typelib file " << typeRegistryPath << " which was referred to as 'type_registriy' for typekit " << typekitName << " in " << tpkg.typekit.sourceFile;
+        LOG_ERROR_S << "Could not parse Typelib file " << typeRegistryPath << " which was referred to as 'type_registriy' for typekit " << typekitName;
         return false;
     }
 
-    // Load types to typeToTypekit.
-    boost::replace_last(typeRegistryPath, "tlb", "typelist");
-    LOG_INFO_S << "Parsing typelist file " <<typeRegistryPath;
-    if(!loadTypeToTypekitMapping(typeRegistryPath, typekitName))
+    // Load types to typeToTypekit, unless enableLazyLoading did it before
+    if(!indexedTypekits.count(typekitName))
     {
-        LOG_ERROR_S << "Could not parse Typelist file " << typeRegistryPath;;
-        return false;
+        boost::replace_last(typeRegistryPath, "tlb", "typelist");
+        LOG_INFO_S << "Parsing typelist file " <<typeRegistryPath;
+        if(!loadTypeToTypekitMapping(typeRegistryPath, typekitName))
+        {
+            LOG_ERROR_S << "Could not parse Typelist file " << typeRegistryPath;;
+            return false;
+        }
+        indexedTypekits.insert(typekitName);
     }
 
     loadedTypekits.push_back(typekitName);
     return true;
 }
 
+bool TypeRegistry::enableLazyLoading()
+{
+    lazyLoading = true;
+    bool loadedAll = true;
+    for(const std::string& typekitName : pkgreg->getRegisteredTypekitNames()){
+        if(indexedTypekits.count(typekitName))
+            continue;
+
+        std::string typelistPath;
+        if(!getTypeRegistryPath(typekitName, typelistPath)){
+            loadedAll = false;
+            continue;
+        }
+        boost::replace_last(typelistPath, "tlb", "typelist");
+        LOG_INFO_S << "Parsing typelist file " << typelistPath;
+        if(!loadTypeToTypekitMapping(typelistPath, typekitName)){
+            LOG_ERROR_S << "Could not parse Typelist file " << typelistPath;
+            loadedAll = false;
+            continue;
+        }
+        indexedTypekits.insert(typekitName);
+    }
+    return loadedAll;
+}
+
+bool TypeRegistry::loadTypekitDefiningType(const std::string &typeName)
+{
+    std::string typekitName;
+    if(!lazyLoading || !getTypekitDefiningType(typeName, typekitName))
+        return false;
+    if(std::find(loadedTypekits.begin(), loadedTypekits.end(), typekitName) != loadedTypekits.end() ||
+       unloadableTypekits.count(typekitName))
+        return false;
+
+    LOG_INFO_S << "Loading typekit " << typekitName << " on demand for type " << typeName;
+    if(!loadTypeRegistry(typekitName)){
+        unloadableTypekits.insert(typekitName);
+        return false;
+    }
+    return true;
+}
+
+//! Task states are enums named after their task model, e.g. /auv_control/AccelerationController_STATES
+static bool is_state_type(const std::string& typeName)
+{
+    return typeName.find("_STATES") != std::string::npos;
+}
+
+static void collect_state_types(const Typelib::Registry& registry, std::vector<std::string>& typeNames)
+{
+    for(Typelib::RegistryIterator it = registry.begin(); it != registry.end(); ++it){
+        if(!it.isAlias() && is_state_type(it->getName()))
+            typeNames.push_back(it->getName());
+    }
+}
+
+//! Top level element of a tlb file, i.e. the definition of one type
+struct TlbDefinition
+{
+    std::string name;
+    size_t begin;
+    size_t end;
+};
+
+static std::string decode_xml_entities(const std::string& value)
+{
+    static const std::pair<const char*, char> entities[] = {
+        {"&lt;", '<'}, {"&gt;", '>'}, {"&quot;", '"'}, {"&apos;", '\''}, {"&amp;", '&'}
+    };
+    std::string ret;
+    ret.reserve(value.size());
+    for(size_t i = 0; i < value.size(); i++){
+        bool decoded = false;
+        if(value[i] == '&'){
+            for(const auto& entity : entities){
+                size_t len = strlen(entity.first);
+                if(value.compare(i, len, entity.first) == 0){
+                    ret += entity.second;
+                    i += len - 1;
+                    decoded = true;
+                    break;
+                }
+            }
+        }
+        if(!decoded)
+            ret += value[i];
+    }
+    return ret;
+}
+
+//Returns the decoded value of \p attribute of the tag [begin, end) in \p content
+static std::string get_xml_attribute(const std::string& content, size_t begin, size_t end, const std::string& attribute)
+{
+    const std::string key = attribute + "=";
+    for(size_t pos = content.find(key, begin); pos < end; pos = content.find(key, pos + 1)){
+        size_t quote = pos + key.size();
+        if(!isspace(content[pos-1]) || quote >= end || (content[quote] != '\'' && content[quote] != '"'))
+            continue;
+        size_t value_end = content.find(content[quote], quote + 1);
+        if(value_end >= end)
+            return std::string();
+        return decode_xml_entities(content.substr(quote + 1, value_end - quote - 1));
+    }
+    return std::string();
+}
+
+//Returns the position of the '>' that closes the tag starting at \p begin
+static size_t find_tag_end(const std::string& content, size_t begin)
+{
+    char quote = 0;
+    for(size_t pos = begin; pos < content.size(); pos++){
+        char c = content[pos];
+        if(quote){
+            if(c == quote)
+                quote = 0;
+        }else if(c == '\'' || c == '"'){
+            quote = c;
+        }else if(c == '>'){
+            return pos;
+        }
+    }
+    return std::string::npos;
+}
+
+//!
+//! \brief Splits the content of a tlb file into its type definitions
+//! Only the structure of the file is scanned, the definitions are not interpreted.
+//! \param bodyBegin, bodyEnd : Range between '<typelib>' and '</typelib>'
+//! \return false if the file is not structured as expected
+//!
+static bool split_tlb(const std::string& content, std::vector<TlbDefinition>& definitions, size_t& bodyBegin, size_t& bodyEnd)
+{
+    size_t pos = content.find("<typelib");
+    if(pos == std::string::npos || (pos = find_tag_end(content, pos)) == std::string::npos)
+        return false;
+    bodyBegin = pos + 1;
+
+    int depth = 0;
+    while((pos = content.find('<', pos)) != std::string::npos){
+        const char* skipUntil = nullptr;
+        if(content.compare(pos, 4, "<!--") == 0)
+            skipUntil = "-->";
+        else if(content.compare(pos, 9, "<![CDATA[") == 0)
+            skipUntil = "]]>";
+        else if(content.compare(pos, 2, "<?") == 0)
+            skipUntil = "?>";
+        if(skipUntil){
+            pos = content.find(skipUntil, pos);
+            if(pos == std::string::npos)
+                return false;
+            continue;
+        }
+
+        size_t tagEnd = find_tag_end(content, pos);
+        if(tagEnd == std::string::npos)
+            return false;
+        if(content[pos+1] == '/'){
+            if(depth == 0){
+                //</typelib>
+                bodyEnd = pos;
+                return true;
+            }
+            if(--depth == 0)
+                definitions.back().end = tagEnd + 1;
+        }else{
+            if(depth == 0){
+                definitions.push_back(TlbDefinition());
+                definitions.back().begin = pos;
+                definitions.back().name = get_xml_attribute(content, pos, tagEnd, "name");
+            }
+            if(content[tagEnd-1] == '/'){
+                if(depth == 0)
+                    definitions.back().end = tagEnd + 1;
+            }else{
+                depth++;
+            }
+        }
+        pos = tagEnd + 1;
+    }
+    return false;
+}
+
+//Records the text of the definitions of a tlb file by type name. Known
+//definitions are kept, unless \p overwrite is set.
+static void remember_definitions(std::unordered_map<std::string, std::string>& known, const std::string& content, const std::vector<TlbDefinition>& definitions, bool overwrite)
+{
+    for(const TlbDefinition& def : definitions){
+        std::string text = content.substr(def.begin, def.end - def.begin);
+        if(overwrite)
+            known[def.name].swap(text);
+        else
+            known.emplace(def.name, std::move(text));
+    }
+}
+
 bool TypeRegistry::loadTypeRegistries()
+{
+    return loadTypekitRegistries(pkgreg->getRegisteredTypekitNames(), 1);
+}
+
+bool TypeRegistry::loadTypekitRegistries(const std::vector<std::string> &typekitNames, unsigned nWorkers)
 {
     bool loadedAll = true;
+    if(nWorkers == 1){
+        for(const std::string& typekitName : typekitNames){
+            loadedAll &= loadTypeRegistry(typekitName);
+        }
+        return loadedAll;
+    }
+
+    struct ParsedTypekit
+    {
+        std::string name;
+        std::string tlbPath;
+        Typelib::Registry registry;
+        std::unique_ptr<Typelib::Importer> importer;
+        //Content of the tlb file and its definitions, see importedDefinitions
+        std::string content;
+        std::vector<TlbDefinition> definitions;
+        std::vector<std::string> stateTypes;
+        bool parsed;
+    };
+    std::vector<std::unique_ptr<ParsedTypekit> > parsed;
+    for(const std::string& typekitName : typekitNames){
+        if(std::find(loadedTypekits.begin(), loadedTypekits.end(), typekitName) != loadedTypekits.end()){
+            continue;
+        }
+        std::unique_ptr<ParsedTypekit> typekit(new ParsedTypekit());
+        typekit->name = typekitName;
+        typekit->parsed = false;
+        if(!getTypeRegistryPath(typekitName, typekit->tlbPath)){
+            loadedAll = false;
+            continue;
+        }
+        parsed.push_back(std::move(typekit));
+    }
+
+    //The static Typelib::PluginManager::load takes and drops a reference to
+    //the reference counted PluginManager singleton on each call, which is
+    //not thread-safe. Hold a single reference for the whole parallel
+    //section and create one importer per tlb file on this thread instead.
+    //The workers then only use their own importer and registry. This relies
+    //on the tlb importer keeping no state outside of its instance, and on
+    //libxml2 being thread-safe once it is initialized, which happens when
+    //the first file is parsed on this thread, before starting the workers.
+    Typelib::PluginManager::self manager;
+    const utilmm::config_set config;
+    for(const std::unique_ptr<ParsedTypekit>& typekit : parsed){
+        typekit->importer.reset(manager->importer("tlb"));
+    }
 
-    for(const std::string& typekitName :  pkgreg->getRegisteredTypekitNames()){
-        loadedAll &= loadTypeRegistry(typekitName);
+    //Parse each tlb file into its own registry
+    auto parse = [&](size_t i){
+        ParsedTypekit& typekit = *parsed[i];
+        LOG_INFO_S << "Parsing Typlib file " << typekit.tlbPath;
+        try{
+            std::ifstream in(typekit.tlbPath, std::ios::in | std::ios::binary);
+            typekit.content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            size_t bodyBegin, bodyEnd;
+            if(!in.is_open() || !split_tlb(typekit.content, typekit.definitions, bodyBegin, bodyEnd)){
+                //Let Typelib report the error
+                typekit.definitions.clear();
+                typekit.importer->load(typekit.tlbPath, config, typekit.registry);
+            }else{
+                std::istringstream stream(typekit.content);
+                typekit.importer->load(stream, config, typekit.registry);
+            }
+            collect_state_types(typekit.registry, typekit.stateTypes);
+            typekit.parsed = true;
+        } catch (const Typelib::ImportError& e){
+            //Reported when merging, like loadTypeRegistry does
+        }
+    };
+    if(!parsed.empty()){
+        parse(0);
+        parallel_for(parsed.size() - 1, nWorkers, [&](size_t i){ parse(i + 1); });
+    }
+
+    //Merge in the order of typekitNames, so that the result does not depend
+    //on the order in which the workers finished
+    for(const std::unique_ptr<ParsedTypekit>& typekit : parsed){
+        if(!typekit->parsed){
+            LOG_ERROR_S << "Could not load tlb path: " << typekit->tlbPath;
+            loadedAll = false;
+            continue;
+        }
+        registry->merge(typekit->registry);
+        remember_definitions(importedDefinitions, typekit->content, typekit->definitions, false);
+        std::string().swap(typekit->content);
+        importedStateTypes.insert(importedStateTypes.end(), typekit->stateTypes.begin(), typekit->stateTypes.end());
+        loadedAll &= loadTypekitIndexes(typekit->name, typekit->tlbPath);
     }
     return loadedAll;
 }
 
-bool TypeRegistry::loadTypelibRegistry(const std::string &path)
+bool TypeRegistry::getTypeRegistryPath(const std::string &typekitName, std::string &path)
 {
+    TypekitPkgConfigConstPtr tpkg = pkgreg->getTypekit(typekitName);
+    if(!tpkg){
+        LOG_ERROR_S << "Could not retrieve Tpekit from PkgConfigRegistry";
+        return false;
+    }
+
+    if(!tpkg->typekit.getVariable("type_registry", path)){
+        LOG_INFO_S << "PkgConfig file of typekit " << typekitName << " does not specify the type_registry variable";
+        return false;
+    }
+    return true;
+}
+
+static void write_uint64(std::ostream& os, uint64_t v)
+{
+    os.write(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+static bool read_uint64(std::istream& is, uint64_t& v)
+{
+    return bool(is.read(reinterpret_cast<char*>(&v), sizeof(v)));
+}
+
+static void write_string(std::ostream& os, const std::string& s)
+{
+    write_uint64(os, s.size());
+    os.write(s.data(), s.size());
+}
+
+static bool read_string(std::istream& is, std::string& s)
+{
+    uint64_t size;
+    if(!read_uint64(is, size))
+        return false;
+    s.resize(size);
+    return size == 0 || bool(is.read(&s[0], size));
+}
+
+//FNV-1a hash of the content of \p path, 0 if it cannot be read
+static uint64_t file_hash(const std::string& path)
+{
+    std::ifstream is(path, std::ios::in | std::ios::binary);
+    if(!is.is_open()){
+        return 0;
+    }
+    uint64_t hash = 14695981039346656037ULL;
+    char buffer[65536];
+    while(is.read(buffer, sizeof(buffer)) || is.gcount() > 0){
+        for(std::streamsize i=0; i<is.gcount(); i++){
+            hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+//Appends modification time, size and content hash of \p path to \p key.
+//The hash catches files that were rewritten within the resolution of the
+//modification time, or restored with their old modification time.
+static void write_file_stamp(std::ostream& key, const std::string& path)
+{
+    write_string(key, path);
+    struct stat st;
+    uint64_t stamp[4] = {0, 0, 0, 0};
+    if(stat(path.c_str(), &st) == 0){
+        stamp[0] = st.st_mtim.tv_sec;
+        stamp[1] = st.st_mtim.tv_nsec;
+        stamp[2] = st.st_size;
+        stamp[3] = file_hash(path);
+    }
+    key.write(reinterpret_cast<const char*>(stamp), sizeof(stamp));
+}
+
+static const char cache_magic[] = "orocos_cpp-typeregistry-cache-4";
+
+bool TypeRegistry::makeCacheKey(const std::vector<std::string> &typekitNames, std::string &key)
+{
+    std::ostringstream os;
+    write_uint64(os, typekitNames.size());
+    for(const std::string& typekitName : typekitNames){
+        std::string tlbPath;
+        if(!getTypeRegistryPath(typekitName, tlbPath)){
+            return false;
+        }
+        write_string(os, typekitName);
+        write_file_stamp(os, tlbPath);
+        boost::replace_last(tlbPath, "tlb", "typelist");
+        write_file_stamp(os, tlbPath);
+    }
+    key = os.str();
+    return true;
+}
+
+bool TypeRegistry::loadTypeRegistries(const std::string &cacheFile, unsigned nWorkers)
+{
+    std::vector<std::string> typekitNames = pkgreg->getRegisteredTypekitNames();
+    if(cacheFile.empty()){
+        return loadTypekitRegistries(typekitNames, nWorkers);
+    }
+
+    std::string key;
+    bool haveKey = makeCacheKey(typekitNames, key);
+    if(haveKey && loadCache(cacheFile, key)){
+        LOG_INFO_S << "Restored type registry of " << typekitNames.size() << " typekits from " << cacheFile;
+        return true;
+    }
+
+    bool loadedAll = loadTypekitRegistries(typekitNames, nWorkers);
+    if(loadedAll && haveKey && !saveCache(cacheFile, key)){
+        LOG_WARN_S << "Could not write type registry cache " << cacheFile;
+    }
+    return loadedAll;
+}
+
+bool TypeRegistry::loadCache(const std::string &cacheFile, const std::string &key)
+{
+    std::ifstream is(cacheFile, std::ios::in | std::ios::binary);
+    if(!is.is_open()){
+        return false;
+    }
+
+    std::string magic, cachedKey, tlb;
+    if(!read_string(is, magic) || magic != cache_magic ||
+       !read_string(is, cachedKey) || cachedKey != key){
+        LOG_INFO_S << "Type registry cache " << cacheFile << " is outdated";
+        return false;
+    }
+
+    //Indexes are restored as they are
+    std::vector<std::string> cachedTypekits;
+    std::vector<std::pair<std::string, std::string> > cachedTypes;
+    std::vector<std::shared_ptr<TaskStateTable> > cachedStates;
+    std::unordered_map<std::string, std::string> cachedDefinitions;
+    uint64_t size;
+    bool ok = read_uint64(is, size);
+    for(uint64_t i=0; ok && i<size; i++){
+        cachedTypekits.push_back(std::string());
+        ok = read_string(is, cachedTypekits.back());
+    }
+    ok = ok && read_uint64(is, size);
+    for(uint64_t i=0; ok && i<size; i++){
+        cachedTypes.push_back(std::pair<std::string, std::string>());
+        ok = read_string(is, cachedTypes.back().first) && read_string(is, cachedTypes.back().second);
+    }
+    ok = ok && read_uint64(is, size);
+    for(uint64_t i=0; ok && i<size; i++){
+        std::string modelName;
+        uint64_t n_states;
+        ok = read_string(is, modelName) && read_uint64(is, n_states);
+        cachedStates.push_back(std::make_shared<TaskStateTable>(modelName));
+        for(uint64_t j=0; ok && j<n_states; j++){
+            std::string stateName;
+            uint64_t id;
+            ok = read_string(is, stateName) && read_uint64(is, id);
+            cachedStates.back()->addState(stateName, id);
+        }
+    }
+    ok = ok && read_uint64(is, size);
+    for(uint64_t i=0; ok && i<size; i++){
+        std::string name, text;
+        ok = read_string(is, name) && read_string(is, text);
+        cachedDefinitions[name].swap(text);
+    }
+    ok = ok && read_string(is, tlb);
+    if(!ok){
+        LOG_WARN_S << "Type registry cache " << cacheFile << " is corrupt";
+        return false;
+    }
+
+    //The merged registry holds every type once, so it is parsed much faster
+    //than the tlb files of all typekits, which repeat the imported types
+    Typelib::Registry cachedRegistry;
     try{
-        Typelib::PluginManager::load("tlb", path, *registry.get());
-    } catch (const Typelib::ImportError& e){
+        std::istringstream tlbStream(tlb);
+        Typelib::PluginManager::load("tlb", tlbStream, cachedRegistry);
+        registry->merge(cachedRegistry);
+    } catch (const std::runtime_error& e){
+        LOG_WARN_S << "Could not restore type registry from cache " << cacheFile << ": " << e.what();
         return false;
     }
+
+    for(const std::pair<std::string, std::string>& type : cachedTypes){
+        typeToTypekit.insert(type.first, internTypekitName(type.second));
+    }
+    for(const std::shared_ptr<TaskStateTable>& table : cachedStates){
+        addStateTable(table);
+    }
+    importedDefinitions.insert(std::make_move_iterator(cachedDefinitions.begin()), std::make_move_iterator(cachedDefinitions.end()));
+    for(const std::string& typekitName : cachedTypekits){
+        if(std::find(loadedTypekits.begin(), loadedTypekits.end(), typekitName) == loadedTypekits.end()){
+            loadedTypekits.push_back(typekitName);
+        }
+    }
     return true;
 }
 
-bool TypeRegistry::loadStateToIDMapping(const std::string &path)
+bool TypeRegistry::saveCache(const std::string &cacheFile, const std::string &key)
+{
+    std::string tlb;
+    try{
+        tlb = Typelib::PluginManager::save("tlb", *registry);
+    } catch (const std::runtime_error& e){
+        LOG_WARN_S << "Could not export type registry: " << e.what();
+        return false;
+    }
+
+    //Write to a temporary file first, so that concurrently starting processes
+    //never read a partially written cache
+    std::string tmpFile = cacheFile + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream os(tmpFile, std::ios::out | std::ios::binary | std::ios::trunc);
+        if(!os.is_open()){
+            return false;
+        }
+
+        write_string(os, cache_magic);
+        write_string(os, key);
+        write_uint64(os, loadedTypekits.size());
+        for(const std::string& typekitName : loadedTypekits){
+            write_string(os, typekitName);
+        }
+        write_uint64(os, typeToTypekit.size());
+        typeToTypekit.forEach([&](const std::string& typeName, unsigned typekit){
+            write_string(os, typeName);
+            write_string(os, typekitNames[typekit]);
+        });
+        write_uint64(os, stateTables.size());
+        for(const auto& kv : stateTables){
+            write_string(os, kv.first);
+            write_uint64(os, kv.second->getStateIDs().size());
+            for(const auto& state : kv.second->getStateIDs()){
+                write_string(os, state.first);
+                write_uint64(os, state.second);
+            }
+        }
+        write_uint64(os, importedDefinitions.size());
+        for(const auto& kv : importedDefinitions){
+            write_string(os, kv.first);
+            write_string(os, kv.second);
+        }
+        write_string(os, tlb);
+        if(!os.good()){
+            os.close();
+            boost::filesystem::remove(tmpFile);
+            return false;
+        }
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::rename(tmpFile, cacheFile, ec);
+    if(ec){
+        boost::filesystem::remove(tmpFile, ec);
+        return false;
+    }
+    return true;
+}
+
+bool TypeRegistry::loadTypelibRegistry(const std::string &path)
+{
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<TlbDefinition> definitions;
+    size_t bodyBegin = 0, bodyEnd = 0;
+    if(!in.is_open() || !split_tlb(content, definitions, bodyBegin, bodyEnd)){
+        //Let Typelib report the error
+        Typelib::Registry imported;
+        try{
+            Typelib::PluginManager::load("tlb", path, imported);
+        } catch (const Typelib::ImportError& e){
+            return false;
+        }
+        registry->merge(imported);
+        collect_state_types(imported, importedStateTypes);
+        return true;
+    }
+
+    //Definitions that were imported before from another tlb file are skipped.
+    //The tlb importer resolves the types the remaining definitions refer to
+    //in the registry it imports into, so the known ones are not needed.
+    std::vector<bool> import(definitions.size(), false);
+    for(size_t i = 0; i < definitions.size(); i++){
+        const TlbDefinition& def = definitions[i];
+        std::unordered_map<std::string, std::string>::const_iterator known = importedDefinitions.find(def.name);
+        import[i] = known == importedDefinitions.end() ||
+                    known->second.compare(0, std::string::npos, content, def.begin, def.end - def.begin) != 0 ||
+                    !registry->has(def.name, false);
+    }
+
+    size_t n_import = std::count(import.begin(), import.end(), true);
+    importStatistics.importedTypes += n_import;
+    importStatistics.skippedTypes += definitions.size() - n_import;
+    LOG_DEBUG_S << "Importing " << n_import << " of " << definitions.size() << " types from " << path;
+    if(n_import > 0){
+        try{
+            if(n_import == definitions.size()){
+                Typelib::PluginManager::load("tlb", path, *registry.get());
+            }else{
+                std::string filtered = content.substr(0, bodyBegin);
+                for(size_t i = 0; i < definitions.size(); i++){
+                    if(import[i]){
+                        filtered.append(content, definitions[i].begin, definitions[i].end - definitions[i].begin);
+                        filtered += "\n";
+                    }
+                }
+                filtered.append(content, bodyEnd, std::string::npos);
+                std::istringstream stream(filtered);
+                Typelib::PluginManager::load("tlb", stream, *registry.get());
+            }
+        } catch (const Typelib::ImportError& e){
+            return false;
+        }
+    }
+
+    remember_definitions(importedDefinitions, content, definitions, true);
+    for(size_t i = 0; i < definitions.size(); i++){
+        if(import[i] && is_state_type(definitions[i].name))
+            importedStateTypes.push_back(definitions[i].name);
+    }
+    return true;
+}
+
+TypeRegistry::ImportStatistics TypeRegistry::getImportStatistics() const
+{
+    return importStatistics;
+}
+
+bool TypeRegistry::loadImportedStateTables()
 {
-    Typelib::RegistryIterator it = registry->begin();
-    Typelib::RegistryIterator itEnd = registry->end();
-    for (; it != itEnd; ++it)
+    // Only the state types imported since the last call are new
+    std::vector<std::string> stateTypes;
+    stateTypes.swap(importedStateTypes);
+    for (const std::string& typeName : stateTypes)
     {
-        // Check if type has states.
-        if(it->getName().find("_STATES") == std::string::npos)
+        const Typelib::Type* type = registry->get(typeName);
+        if(!type || type->getCategory() != Typelib::Type::Enum)
             continue;
 
-        std::size_t length = it.getNamespace().find_last_of("/");
-        const std::string nameSpace = it->getNamespace().substr(1, length - 1);
+        std::size_t length = type->getNamespace().find_last_of("/");
+        const std::string nameSpace = type->getNamespace().substr(1, length - 1);
 
-        const Typelib::Enum* states = static_cast<const Typelib::Enum*>(&*it);
+        // e.g. /auv_control/AccelerationController_STATES describes the
+        // states of auv_control::AccelerationController
+        std::string baseName = typeName.substr(typeName.find_last_of("/") + 1);
+        const std::string modelPrefix = baseName.substr(0, baseName.rfind("_STATES")) + "_";
+        const std::string modelName = nameSpace + "::" + modelPrefix.substr(0, modelPrefix.size() - 1);
+        if(stateTables.count(modelName))
+            continue;
+
+        std::shared_ptr<TaskStateTable> table = std::make_shared<TaskStateTable>(modelName);
+        const Typelib::Enum* states = static_cast<const Typelib::Enum*>(type);
         std::map<std::string, int> state_map = states->values();
 
         auto stateIt = state_map.begin(),
              stateItEnd = state_map.end();
         for (; stateIt != stateItEnd; ++stateIt)
         {
-            std::string taskState = nameSpace + "::" + stateIt->first;
-            taskStateToID.insert(std::make_pair(taskState, stateIt->second));
+            // Symbols are prefixed with the model name, e.g. AccelerationController_CONTROLLING
+            const std::string& symbol = stateIt->first;
+            bool prefixed = symbol.compare(0, modelPrefix.size(), modelPrefix) == 0;
+            table->addState(prefixed ? symbol.substr(modelPrefix.size()) : symbol, stateIt->second);
         }
+        addStateTable(table);
     }
 
     return true;
 }
 
+void TypeRegistry::addStateTable(const std::shared_ptr<TaskStateTable> &table)
+{
+    if(!stateTables.insert(std::make_pair(table->getTaskModelName(), table)).second)
+        return;
+    for(const std::pair<const std::string, unsigned>& state : table->getStateIDs())
+    {
+        taskStateToID.insert(std::make_pair(table->getTaskModelName() + "_" + state.first, state.second));
+    }
+}
+
 bool TypeRegistry::loadTypeToTypekitMapping(const std::string &path, const std::string &typeKitName)
 {
-    std::ifstream in(path);
-    if(in.bad())
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if(!in.is_open())
     {
         return false;
     }
 
-    std::string line;
-    while(!in.eof())
+    //Read the file at once and scan it in place
+    in.seekg(0, std::ios::end);
+    std::string content(std::max<std::streamoff>(in.tellg(), 0), '\0');
+    in.seekg(0, std::ios::beg);
+    if(!content.empty() && !in.read(&content[0], content.size()))
     {
-        std::getline(in, line);
-        size_t e = line.find_first_of(' ');
-        if(e == std::string::npos)
-            continue;
+        return false;
+    }
 
-        std::string typeName = line.substr(0, e);
+    const unsigned typekit = internTypekitName(typeKitName);
 
-        typeToTypekit.insert(std::make_pair(typeName, typeKitName));
+    // Each line is '<type name> <flags>'
+    const char* pos = content.data();
+    const char* end = pos + content.size();
+    while(pos < end)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(pos, '\n', end - pos));
+        if(!lineEnd)
+            lineEnd = end;
+        const char* nameEnd = static_cast<const char*>(memchr(pos, ' ', lineEnd - pos));
+        if(nameEnd)
+            typeToTypekit.insert(pos, nameEnd - pos, typekit);
+        pos = lineEnd + 1;
     }
 
     return true;
 }
 
+unsigned TypeRegistry::internTypekitName(const std::string &typekitName)
+{
+    auto it = typekitIDs.find(typekitName);
+    if(it != typekitIDs.end())
+        return it->second;
+    typekitNames.push_back(typekitName);
+    typekitIDs.insert(std::make_pair(typekitName, typekitNames.size() - 1));
+    return typekitNames.size() - 1;
+}
+
 bool TypeRegistry::getTypekitDefiningType(const std::string& typeName, std::string& typekitName)
 {
-    auto it = typeToTypekit.find(typeName);
-    if(it == typeToTypekit.end())
+    unsigned typekit;
+    if(!typeToTypekit.find(typeName, typekit))
         return false;
     
-    typekitName = it->second;
+    typekitName = typekitNames[typekit];
     
     return true;
 }
 
 bool TypeRegistry::hasType(const std::string &typeName)
 {
-    return registry->has(typeName, true);
+    if(registry->has(typeName, true))
+        return true;
+    return loadTypekitDefiningType(typeName) && registry->has(typeName, true);
 }
 
 const Typelib::Type *TypeRegistry::getTypeModel(const std::string &typeName)
 {
-    return registry->get(typeName);
+    const Typelib::Type* type = registry->get(typeName);
+    if(!type && loadTypekitDefiningType(typeName))
+        type = registry->get(typeName);
+    return type;
 }
 
-bool TypeRegistry::getStateID(const std::string &task_model_name, const std::string &state_name, unsigned int &id)
+const TypeHandle *TypeRegistry::resolveType(const std::string &typeName)
+{
+    unsigned id;
+    if(typeHandleIDs.find(typeName, id))
+        return typeHandles[id].get();
+
+    const Typelib::Type* type = getTypeModel(typeName);
+    if(!type)
+        return nullptr;
+
+    std::unique_ptr<TypeHandle> handle(new TypeHandle());
+    handle->id = typeHandles.size();
+    handle->name = typeName;
+    handle->type = type;
+    handle->size = type->getSize();
+    typeHandleIDs.insert(typeName, handle->id);
+    typeHandles.push_back(std::move(handle));
+    return typeHandles.back().get();
+}
+
+const TypeHandle *TypeRegistry::getTypeHandle(unsigned id) const
+{
+    if(id >= typeHandles.size())
+        return nullptr;
+    return typeHandles[id].get();
+}
+
+TaskStateTableConstPtr TypeRegistry::getStateTable(const std::string &task_model_name)
 {
-    std::map<std::string, unsigned>::const_iterator state_it = taskStateToID.find(task_model_name + "_" + state_name);
-    if (state_it == taskStateToID.end()){
+    auto it = stateTables.find(task_model_name);
+    if(it == stateTables.end()){
         std::string typekit_name = task_model_name.substr(0, task_model_name.find(":"));
         if(!loadTypeRegistry(typekit_name))
-            return false;
+            return nullptr;
 
-        state_it = taskStateToID.find(task_model_name + "_" + state_name);
-        if(state_it == taskStateToID.end())
+        it = stateTables.find(task_model_name);
+        if(it == stateTables.end())
         {
-            LOG_ERROR_S << "Task state " << state_name << " is missing in typekit " << typekit_name;
-            return false;
+            LOG_ERROR_S << "Task model " << task_model_name << " has no states in typekit " << typekit_name;
+            return nullptr;
         }
     }
-    
-    id = state_it->second;
-    
-    return true;
+    return it->second;
 }
 
-bool TypeRegistry::getStateName(const std::string &task_model_name, const unsigned int &id, std::string &state_name )
+bool TypeRegistry::getStateID(const std::string &task_model_name, const std::string &state_name, unsigned int &id)
 {
-    for (const std::pair<std::string, unsigned>& elem : taskStateToID)
+    TaskStateTableConstPtr table = getStateTable(task_model_name);
+    if(!table)
+        return false;
+
+    if(!table->getStateID(state_name, id))
     {
-        const std::string& tmodelname_statename = elem.first;
-        if(tmodelname_statename.rfind(task_model_name, 0) == 0 && elem.second == id){
-            state_name = tmodelname_statename.substr(task_model_name.size()+1);
-            return true;
-        }
+        LOG_ERROR_S << "Task state " << state_name << " is missing in typekit " << task_model_name.substr(0, task_model_name.find(":"));
+        return false;
     }
-    return false;
+    return true;
+}
+
+bool TypeRegistry::getStateName(const std::string &task_model_name, const unsigned int &id, std::string &state_name )
+{
+    auto it = stateTables.find(task_model_name);
+    if(it == stateTables.end())
+        return false;
+
+    const std::string* name = it->second->getStateName(id);
+    if(!name)
+        return false;
+    state_name = *name;
+    return true;
+}
+
+TaskStateTable::TaskStateTable(const std::string &taskModelName) :
+    taskModelName(taskModelName)
+{
+}
+
+const std::string &TaskStateTable::getTaskModelName() const
+{
+    return taskModelName;
+}
+
+const std::string *TaskStateTable::getStateName(unsigned id) const
+{
+    if(id >= namesByID.size() || namesByID[id].empty())
+        return nullptr;
+    return &namesByID[id];
+}
+
+bool TaskStateTable::getStateID(const std::string &stateName, unsigned &id) const
+{
+    auto it = idsByName.find(stateName);
+    if(it == idsByName.end())
+        return false;
+    id = it->second;
+    return true;
+}
+
+void TaskStateTable::addState(const std::string &stateName, unsigned id)
+{
+    if(!idsByName.insert(std::make_pair(stateName, id)).second)
+        return;
+    if(id >= namesByID.size())
+        namesByID.resize(id + 1);
+    if(namesByID[id].empty())
+        namesByID[id] = stateName;
+}
+
+const std::unordered_map<std::string, unsigned> &TaskStateTable::getStateIDs() const
+{
+    return idsByName;
 }
 
 }
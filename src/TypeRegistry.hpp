@@ -3,7 +3,11 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "PkgConfigRegistry.hpp"
+#include "TypeNameIndex.hpp"
 #include <typelib/typemodel.hh>
 
 
@@ -18,6 +22,54 @@ namespace orocos_cpp
 class TypeRegistry;
 typedef std::shared_ptr<TypeRegistry> TypeRegistryPtr;
 
+/*!
+ * \brief The states of a task model with their IDs
+ *
+ * Retrieve it once per task model with TypeRegistry::getStateTable. Lookups
+ * in both directions take constant time and do not allocate memory.
+ */
+class TaskStateTable
+{
+public:
+    TaskStateTable(const std::string& taskModelName);
+
+    //! e.g. "auv_control::AccelerationController"
+    const std::string& getTaskModelName() const;
+    //! \return the name of the state with ID \p id (e.g. "CONTROLLING"),
+    //!         or nullptr if the model has no such state
+    const std::string* getStateName(unsigned id) const;
+    //! \return false if the model has no state \p stateName
+    bool getStateID(const std::string& stateName, unsigned& id) const;
+    const std::unordered_map<std::string, unsigned>& getStateIDs() const;
+
+    //! Adds a state. Names and IDs that were added before are kept.
+    void addState(const std::string& stateName, unsigned id);
+
+protected:
+    std::string taskModelName;
+    //! State names indexed by ID, empty for unused IDs
+    std::vector<std::string> namesByID;
+    std::unordered_map<std::string, unsigned> idsByName;
+};
+typedef std::shared_ptr<const TaskStateTable> TaskStateTableConstPtr;
+
+/*!
+ * \brief A type resolved once by TypeRegistry::resolveType
+ *
+ * Handles are owned by the TypeRegistry and stay valid as long as it exists.
+ * Keep them instead of looking up types by name on every use.
+ */
+struct TypeHandle
+{
+    //! Index of the handle, see TypeRegistry::getTypeHandle
+    unsigned id;
+    //! Name the type was resolved by
+    std::string name;
+    const Typelib::Type* type;
+    //! Size of the type in bytes
+    size_t size;
+};
+
 /*!
  * \brief The TypeRegistry class goves access to content from TLB files
  *
@@ -26,8 +78,13 @@ typedef std::shared_ptr<TypeRegistry> TypeRegistryPtr;
 class TypeRegistry
 {
 protected:
-    std::map<std::string, std::string> typeToTypekit;
+    //! Index into \var typekitNames by type name
+    TypeNameIndex typeToTypekit;
+    //! Typekit names referred to by \var typeToTypekit, each stored once
+    std::vector<std::string> typekitNames;
+    std::unordered_map<std::string, unsigned> typekitIDs;
     std::map<std::string, unsigned> taskStateToID;
+    std::unordered_map<std::string, std::shared_ptr<TaskStateTable> > stateTables;
     PkgConfigRegistryPtr pkgreg;
 
 public:
@@ -62,6 +119,50 @@ public:
      * \return true if all Typekits have been loaded successfully
      */
     bool loadTypeRegistries();
+
+    /*!
+     * \brief Load all Typekits that are registered in \p pkgreg, using a cache
+     *
+     * Like loadTypeRegistries(), but the result is stored in \p cacheFile.
+     * Later calls restore the type registry, the task states and the
+     * type to typekit mapping from the cache instead of parsing the tlb and
+     * typelist files of all typekits, as long as the same typekits are
+     * registered and their files did not change (modification time, size
+     * and content hash). Checking the cache reads the tlb and typelist files
+     * to hash them, but does not parse them.
+     *
+     * \param cacheFile : Cache file to use. If empty, no cache is used.
+     * \param nWorkers : Number of threads used to parse the tlb files, see
+     *                   loadTypekitRegistries()
+     * \return true if all Typekits have been loaded successfully
+     */
+    bool loadTypeRegistries(const std::string& cacheFile, unsigned nWorkers=1);
+
+    /*!
+     * \brief Load the registries of the typekits \p typekitNames
+     *
+     * If \p nWorkers is not 1, the tlb files are parsed into separate
+     * registries on \p nWorkers threads (0: one per core), which are merged
+     * into \var registry in the order of \p typekitNames afterwards. The
+     * result and the reported errors are the same as loading the typekits
+     * one after another with loadTypeRegistry.
+     *
+     * \return true if all Typekits have been loaded successfully
+     */
+    bool loadTypekitRegistries(const std::vector<std::string>& typekitNames, unsigned nWorkers);
+
+    /*!
+     * \brief Load typekits on demand
+     *
+     * Reads only the typelist files of all Typekits that are registered in
+     * \p pkgreg, which are much cheaper than their tlb files. Afterwards
+     * getTypekitDefiningType() knows the types of all these typekits, and
+     * hasType() and getTypeModel() load the registry of the one typekit
+     * defining a type that was not loaded before.
+     *
+     * \return true if the typelists of all Typekits have been loaded successfully
+     */
+    bool enableLazyLoading();
     
     bool getTypekitDefiningType(const std::string &typeName, std::string &typekitName);
 
@@ -85,24 +186,87 @@ public:
      * @returns false if the state or the task is unknown and cant be loaded
      */
     bool getStateName(const std::string &task_model_name, const unsigned int &id, std::string &state_name );
+    /**
+     * Returns the states of a task model, for repeated lookups of its states.
+     * If the task model was not added to the TypeRegistry, this function
+     * trigger the loading process.
+     * @param task_model_name e.g. "auv_control::AccelerationController"
+     *
+     * @returns nullptr if the task is unknown and cant be loaded
+     */
+    TaskStateTableConstPtr getStateTable(const std::string &task_model_name);
     bool hasType(const std::string& typeName);
     const Typelib::Type *getTypeModel(const std::string& typeName);
+
+    /**
+     * Resolves a type name to a handle, see TypeHandle. Like getTypeModel,
+     * the defining typekit is loaded if lazy loading is enabled.
+     * Resolving the same name again returns the same handle.
+     * @returns nullptr if the type is unknown
+     */
+    const TypeHandle* resolveType(const std::string& typeName);
+    /**
+     * @returns the handle with TypeHandle::id \p id, or nullptr if there is none
+     */
+    const TypeHandle* getTypeHandle(unsigned id) const;
     std::shared_ptr<Typelib::Registry> registry;
     std::vector<std::string> loadedTypekits;
 
+    struct ImportStatistics
+    {
+        ImportStatistics() : importedTypes(0), skippedTypes(0) {}
+        //! Number of type definitions parsed from tlb files
+        size_t importedTypes;
+        //! Number of type definitions that were skipped, because an
+        //! identical definition was imported from another tlb file before
+        size_t skippedTypes;
+    };
+    ImportStatistics getImportStatistics() const;
+
 protected:
+    /**
+     * Resolves the path to the tlb file of a typekit from its PkgConfig file
+     */
+    bool getTypeRegistryPath(const std::string& typekitName, std::string& path);
+
+    /**
+     * Loads the task states and the typelist of a typekit, after its tlb file
+     * was loaded into \var registry, and marks the typekit as loaded
+     */
+    bool loadTypekitIndexes(const std::string& typekitName, std::string typeRegistryPath);
+
+    /**
+     * Loads the registry of the typekit defining \p typeName, if lazy loading
+     * is enabled and the typekit was not loaded before
+     * @returns true if a typekit was loaded
+     */
+    bool loadTypekitDefiningType(const std::string& typeName);
+
+    /**
+     * Builds the key a cache file is valid for, from the tlb and typelist
+     * files of \p typekitNames
+     */
+    bool makeCacheKey(const std::vector<std::string>& typekitNames, std::string& key);
+    bool loadCache(const std::string& cacheFile, const std::string& key);
+    bool saveCache(const std::string& cacheFile, const std::string& key);
+
     /**
      * Loads a tlb file into meber varibale
      * std::shared_ptr<Typelib::Registry> registry
+     * Every tlb file contains all types its typekit uses, including those of
+     * imported typekits. Definitions that are textually identical to ones
+     * imported from an earlier tlb file are not parsed again.
      * @param path the path to the tlb file
      */
     bool loadTypelibRegistry(const std::string &path);
 
     /**
-     * Saves the stateToIDMapping from a given tlb file.
-     * @param path the path to the tlb file
+     * Builds the state tables and the stateToIDMapping of the task state
+     * types that were imported into \var registry since the last call,
+     * regardless of the tlb file they came from, see \var importedStateTypes.
      */
-    bool loadStateToIDMapping(const std::string &path);
+    bool loadImportedStateTables();
+    void addStateTable(const std::shared_ptr<TaskStateTable>& table);
 
     /**
      * Saves the typeToTypekitMapping from a given typelist file.
@@ -110,5 +274,25 @@ protected:
      * @param typekitName the name of the corresponding typekit
      */
     bool loadTypeToTypekitMapping(const std::string &path, const std::string &typekitName);
+    //! \return the index of \p typekitName in \var typekitNames, adds it if needed
+    unsigned internTypekitName(const std::string& typekitName);
+
+    //! Text of the type definitions of all loaded tlb files by type name.
+    //! loadTypelibRegistry skips definitions with the same name and text.
+    std::unordered_map<std::string, std::string> importedDefinitions;
+    ImportStatistics importStatistics;
+    //! Names of the task state types imported since the last call of loadImportedStateTables
+    std::vector<std::string> importedStateTypes;
+
+    bool lazyLoading;
+    //! Typekits whose typelist was loaded into \var typeToTypekit
+    std::unordered_set<std::string> indexedTypekits;
+    //! Typekits that failed to load on demand, they are not tried again
+    std::unordered_set<std::string> unloadableTypekits;
+
+    //! Handles returned by resolveType, indexed by their id
+    std::vector<std::unique_ptr<TypeHandle> > typeHandles;
+    //! Index into \var typeHandles by type name
+    TypeNameIndex typeHandleIDs;
 };
 }
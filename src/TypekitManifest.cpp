@@ -0,0 +1,137 @@
+#include "TypekitManifest.hpp"
+#include "PkgConfigHelper.hpp"
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define xstr(s) str(s)
+#define str(s) #s
+
+using namespace orocos_cpp;
+
+//Identifies the version of the manifest file format
+static const char manifest_magic[] = "orocos_cpp-typekit-manifest-2";
+
+//Size and modification time of \p path, to detect changed files
+static std::string file_stamp(const std::string &path)
+{
+    struct stat st;
+    if(stat(path.c_str(), &st) != 0)
+        return "-";
+    return std::to_string(st.st_size) + ":" + std::to_string(st.st_mtim.tv_sec) + "." + std::to_string(st.st_mtim.tv_nsec);
+}
+
+//Appends the PKG_CONFIG_PATH to \p key. Installing or removing a package
+//changes the modification time of its directory.
+static void append_search_paths(std::string &key)
+{
+    key += " search_paths";
+    for(const std::string &path : PkgConfigHelper::getSearchPathsFromEnvVar())
+        key += " " + path + " " + file_stamp(path);
+}
+
+std::string TypekitManifest::makeKey(const std::vector<std::string> &transports,
+                                     const std::vector<std::string> &packageNames, bool loadAllPackages)
+{
+    std::string key = "target " xstr(OROCOS_TARGET) " transports";
+    for(const std::string &transport : transports)
+        key += " " + transport;
+    key += loadAllPackages ? " packages all" : " packages";
+    for(const std::string &packageName : packageNames)
+        key += " " + packageName;
+    append_search_paths(key);
+    return key;
+}
+
+std::string TypekitManifest::makeBundleKey(const std::string &bundleFile)
+{
+    std::string key = "target " xstr(OROCOS_TARGET) " bundle " + bundleFile + " " + file_stamp(bundleFile);
+    append_search_paths(key);
+    return key;
+}
+
+bool TypekitManifest::save(const std::string &manifestFile, const std::string &key, const std::vector<Entry> &entries)
+{
+    //Write to a temporary file first, so that concurrently starting processes
+    //never read a partially written manifest
+    std::string tmpFile = manifestFile + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream os(tmpFile, std::ios::out | std::ios::trunc);
+        if(!os.is_open())
+            return false;
+
+        //One tab separated line per library: typekit, transport ('-' for the
+        //typekit itself), stamp of the library, stamp and path of the
+        //PkgConfig file ('-' if unknown) and path of the library
+        os << manifest_magic << "\n" << key << "\n";
+        for(const Entry &entry : entries)
+        {
+            const std::string pkgConfigFile = entry.pkgConfigFile.empty() ? "-" : entry.pkgConfigFile;
+            os << entry.typekit << "\t" << (entry.transport.empty() ? "-" : entry.transport) << "\t"
+               << file_stamp(entry.path) << "\t" << file_stamp(pkgConfigFile) << "\t"
+               << pkgConfigFile << "\t" << entry.path << "\n";
+        }
+        if(!os.good())
+        {
+            os.close();
+            boost::filesystem::remove(tmpFile);
+            return false;
+        }
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::rename(tmpFile, manifestFile, ec);
+    if(ec)
+    {
+        boost::filesystem::remove(tmpFile, ec);
+        return false;
+    }
+    return true;
+}
+
+TypekitManifest::Status TypekitManifest::load(const std::string &manifestFile, const std::string &key, std::vector<Entry> &entries)
+{
+    std::ifstream is(manifestFile);
+    if(!is.is_open())
+        return MISSING;
+
+    std::string line;
+    if(!std::getline(is, line) || line != manifest_magic)
+        return CORRUPT;
+    if(!std::getline(is, line))
+        return CORRUPT;
+    if(line != key)
+        return OTHER_KEY;
+
+    //Check all entries before returning any of them
+    std::vector<Entry> ret;
+    while(std::getline(is, line))
+    {
+        std::istringstream fields(line);
+        Entry entry;
+        std::string stamp, pkgConfigStamp;
+        if(!std::getline(fields, entry.typekit, '\t') || !std::getline(fields, entry.transport, '\t') ||
+           !std::getline(fields, stamp, '\t') || !std::getline(fields, pkgConfigStamp, '\t') ||
+           !std::getline(fields, entry.pkgConfigFile, '\t') || !std::getline(fields, entry.path) ||
+           entry.typekit.empty() || entry.path.empty())
+        {
+            return CORRUPT;
+        }
+        if(stamp == "-" || stamp != file_stamp(entry.path))
+            return OUTDATED;
+        if(entry.pkgConfigFile == "-")
+            entry.pkgConfigFile.clear();
+        else if(pkgConfigStamp != file_stamp(entry.pkgConfigFile))
+            return OUTDATED;
+        if(entry.transport == "-")
+            entry.transport.clear();
+        ret.push_back(entry);
+    }
+    if(!is.eof())
+        return CORRUPT;
+
+    entries.swap(ret);
+    return VALID;
+}
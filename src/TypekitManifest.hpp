@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace orocos_cpp
+{
+
+/*!
+ * \brief File listing typekit and transport libraries in load order
+ *
+ * A manifest is written after the typekits were loaded through the PkgConfig
+ * files, so that later starts can load the same libraries without scanning
+ * for them. It is only valid for the key it was written with, see makeKey,
+ * and as long as none of the listed libraries and PkgConfig files changed.
+ */
+class TypekitManifest
+{
+public:
+    //! A library listed in a manifest
+    struct Entry
+    {
+        std::string typekit;
+        //! Transport the library provides, empty for the typekit itself
+        std::string transport;
+        std::string path;
+        //! PkgConfig file the library was resolved from, empty if unknown
+        std::string pkgConfigFile;
+    };
+
+    enum Status { VALID, MISSING, OTHER_KEY, CORRUPT, OUTDATED };
+
+    /**
+     * Builds the key of a manifest from everything that decides which
+     * libraries are loaded: OROCOS_TARGET, the \p transports, the packages
+     * the PkgConfigRegistry is initialized with, and the PKG_CONFIG_PATH
+     * together with the modification times of its directories. The key does
+     * not depend on the content of the PkgConfig files, so it can be built
+     * before they are scanned.
+     * */
+    static std::string makeKey(const std::vector<std::string> &transports,
+                               const std::vector<std::string> &packageNames, bool loadAllPackages);
+
+    /**
+     * Builds the key of the manifest that lists the libraries of the typekit
+     * bundle \p bundleFile, see PluginHelper::buildTypekitBundle. It covers
+     * OROCOS_TARGET, the bundle itself and, like makeKey, the PKG_CONFIG_PATH.
+     * */
+    static std::string makeBundleKey(const std::string &bundleFile);
+
+    /**
+     * Writes \p entries with \p key to \p manifestFile. The file is replaced
+     * atomically, so concurrently starting processes never read a partially
+     * written manifest.
+     * @return false if the file could not be written
+     * */
+    static bool save(const std::string &manifestFile, const std::string &key, const std::vector<Entry> &entries);
+
+    /**
+     * Reads the entries of \p manifestFile, if it was written with \p key and
+     * none of the libraries and PkgConfig files changed since.
+     * @return VALID if \p entries were read, the reason why not otherwise
+     * */
+    static Status load(const std::string &manifestFile, const std::string &key, std::vector<Entry> &entries);
+};
+
+}
@@ -4,6 +4,9 @@
 #include <lib_config/YAMLConfiguration.hpp>
 #include <boost/lexical_cast.hpp>
 #include "PluginHelper.hpp"
+#include "TypekitManifest.hpp"
+#include <rtt/OperationCaller.hpp>
+#include <algorithm>
 
 
 namespace orocos_cpp {
@@ -106,6 +109,11 @@ bool OrocosCpp::initialize(const OrocosCppConfig& config, bool quiet)
 {
     bool st;
 
+    if(!PluginHelper::setDefaultTransports(config.typekit_transports)){
+        std::cerr << "Error, typekit_transports may only contain corba, mqueue and typelib" << std::endl;
+        return false;
+    }
+
     //Init CORBA
     if(config.init_corba){
         if(!quiet) std::cout << "Initializing CORBA.. " << std::endl;
@@ -116,19 +124,38 @@ bool OrocosCpp::initialize(const OrocosCppConfig& config, bool quiet)
         }
     }
 
+    // Set orocos log file
+    if(config.oro_log_file_path == ""){
+        set_env("ORO_LOGFILE", default_oro_log_file_path(), true);
+    }else{
+        set_env("ORO_LOGFILE", config.oro_log_file_path, true);
+    }
+
+    //Typekits from a bundle or a valid manifest are loaded before the
+    //PkgConfig files are scanned, as they do not need them
+    bool typekitsLoaded = false;
+    std::string manifestKey;
+    if(config.load_typekits){
+        if(!quiet && (!config.typekit_bundle_file.empty() || !config.typekit_manifest_file.empty()))
+            std::cout << "\nLoading Typekits.." << std::endl;
+        if(!config.typekit_bundle_file.empty() && !PluginHelper::loadTypekitBundle(config.typekit_bundle_file)){
+            std::cerr << "Could not load typekit bundle " << config.typekit_bundle_file << std::endl;
+        }
+        if(!config.typekit_manifest_file.empty()){
+            manifestKey = TypekitManifest::makeKey(config.typekit_transports, config.package_initialization_whitelist, config.load_all_packages);
+            typekitsLoaded = PluginHelper::replayTypekitManifest(config.typekit_manifest_file, manifestKey, config.typekit_prefetch_workers);
+        }
+    }
+
     //Init PkgConfig Registry
     if(!quiet) std::cout << "\nLoading Rock-packages.." << std::endl;
-    package_registry = PkgConfigRegistry::initialize(config.package_initialization_whitelist, config.load_all_packages);
+    package_registry = PkgConfigRegistry::initialize(config.package_initialization_whitelist, config.load_all_packages, config.package_registry_cache_file, config.package_scan_workers);
     if(!package_registry){
         std::cerr << "Error initializing Rock-packages" <<std::endl;
         return false;
     }
-
-    // Set orocos log file
-    if(config.oro_log_file_path == ""){
-        set_env("ORO_LOGFILE", default_oro_log_file_path(), true);
-    }else{
-        set_env("ORO_LOGFILE", config.oro_log_file_path, true);
+    if(config.watch_package_changes && !package_registry->watchSearchPaths()){
+        std::cerr << "Could not watch Rock-packages for changes" << std::endl;
     }
 
     //Init Bundle
@@ -149,15 +176,18 @@ bool OrocosCpp::initialize(const OrocosCppConfig& config, bool quiet)
     }
 
     //Load Typekits
-    if(config.load_typekits){
+    if(config.load_typekits && !typekitsLoaded){
         if(!quiet) std::cout << "\nLoading Typekits.." << std::endl;
-        for(std::string tkn : package_registry->getRegisteredTypekitNames())
+        std::vector<std::string> typekitNames = package_registry->getRegisteredTypekitNames();
+        if(!PluginHelper::loadTypekitsAndTransports(typekitNames, config.typekit_prefetch_workers)){
+            std::cerr << "Could not load all typekits" << std::endl;
+        }
+        //The manifest lists what was loaded, also if some typekits failed.
+        //Installing a package changes the key and thus invalidates it
+        if(!config.typekit_manifest_file.empty() &&
+           !PluginHelper::saveTypekitManifest(config.typekit_manifest_file, manifestKey))
         {
-            try{
-                PluginHelper::loadTypekitAndTransports(tkn);
-            }catch(std::runtime_error& ex){
-                std::cerr << ex.what() << std::endl;
-            }
+            std::cerr << "Could not write typekit manifest " << config.typekit_manifest_file << std::endl;
         }
     }
 
@@ -166,7 +196,10 @@ bool OrocosCpp::initialize(const OrocosCppConfig& config, bool quiet)
     type_registry = TypeRegistryPtr(new TypeRegistry(package_registry));
     if(config.init_type_registry){
         if(!quiet) std::cout << "\nLoading Type Registry.." << std::endl;
-        st = type_registry->loadTypeRegistries();
+        if(config.type_registry_lazy_loading)
+            st = type_registry->enableLazyLoading();
+        else
+            st = type_registry->loadTypeRegistries(config.type_registry_cache_file, config.type_registry_load_workers);
         if(!st){
             std::cerr << "Error during initialization of TypeRegistry" << std::endl;
             return false;
@@ -179,6 +212,28 @@ bool OrocosCpp::initialize(const OrocosCppConfig& config, bool quiet)
 
 RTT::corba::TaskContextProxy *OrocosCpp::getTaskContext(std::string name)
 {
+    RTT::corba::TaskContextProxy *proxy = RTT::corba::TaskContextProxy::Create(name);
+
+    //The ports of the proxy need the corba transports of their types, which
+    //are loaded on demand if corba is not a default transport
+    const std::vector<std::string> &transports(PluginHelper::getDefaultTransports());
+    if(!proxy || std::find(transports.begin(), transports.end(), "corba") != transports.end())
+        return proxy;
+
+    RTT::OperationInterfacePart *op = proxy->getOperation("getModelName");
+    if(!op)
+        return proxy;
+    std::string modelName = RTT::OperationCaller<std::string()>(op)();
+    try{
+        if(!PluginHelper::loadAllTypekitsForModel(modelName, PluginHelper::getDefaultTransportsWith("corba")))
+            return proxy;
+    }catch(std::runtime_error& ex){
+        std::cerr << "Could not load the corba transports for " << name << ": " << ex.what() << std::endl;
+        return proxy;
+    }
+
+    //ports of types without transport were not created, see LoggingHelper::logAllPorts
+    delete proxy;
     return RTT::corba::TaskContextProxy::Create(name);
 }
 
@@ -0,0 +1,105 @@
+#include "PkgConfigHelper.hpp"
+#include <base/Time.hpp>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+
+using namespace orocos_cpp;
+namespace fs = boost::filesystem;
+
+//! Micro-benchmark for PkgConfigHelper::parsePkgConfig
+//!
+//! Usage: benchmark_pkgconfig_helper [fixture_dir] [corpus_size] [iterations]
+//!
+//! Parses every file in fixture_dir (default: the test_pkgconfig fixtures)
+//! iterations times and then parses a generated corpus of corpus_size files
+//! that are derived from the fixtures.
+
+static std::vector<fs::path> listPkgConfigFiles(const fs::path& dir)
+{
+    std::vector<fs::path> files;
+    for(fs::directory_iterator it(dir); it != fs::directory_iterator(); ++it){
+        if(fs::is_regular_file(*it) && it->path().extension() == ".pc")
+            files.push_back(it->path());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static std::string readFile(const fs::path& path)
+{
+    std::ifstream in(path.string());
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static size_t parseAll(const std::vector<fs::path>& files)
+{
+    size_t n_entries = 0;
+    for(const fs::path& file : files){
+        std::map<std::string, std::string> variables, properties;
+        PkgConfigHelper::parsePkgConfig(file.string(), variables, properties);
+        n_entries += variables.size() + properties.size();
+    }
+    return n_entries;
+}
+
+int main(int argc, char** argv)
+{
+    fs::path fixtureDir = argc > 1 ? argv[1] : "../../test/test_pkgconfig";
+    int corpusSize = argc > 2 ? atoi(argv[2]) : 10000;
+    int iterations = argc > 3 ? atoi(argv[3]) : 1000;
+    if(corpusSize <= 0 || iterations <= 0){
+        std::cerr << "corpus_size and iterations have to be positive" << std::endl;
+        return 1;
+    }
+
+    std::vector<fs::path> fixtures = listPkgConfigFiles(fixtureDir);
+    if(fixtures.empty()){
+        std::cerr << "No PkgConfig files found in " << fixtureDir << std::endl;
+        return 1;
+    }
+
+    //Fixtures
+    size_t n_entries = 0;
+    base::Time start = base::Time::now();
+    for(int i=0; i<iterations; i++){
+        n_entries += parseAll(fixtures);
+    }
+    base::Time end = base::Time::now();
+    size_t n_parsed = iterations * fixtures.size();
+    std::cout << "Fixtures: parsed " << n_parsed << " files (" << n_entries << " entries) in "
+              << (end - start).toSeconds() << " Seconds, "
+              << (end - start).toMicroseconds() / n_parsed << " us per file" << std::endl;
+
+    //Generated corpus. Each file is a copy of a fixture with unique variable
+    //values, so the parser has to do real work on every file.
+    fs::path corpusDir = fs::temp_directory_path() / fs::unique_path("orocos_cpp_pkgconfig_%%%%-%%%%");
+    fs::create_directories(corpusDir);
+    std::vector<std::string> templates;
+    for(const fs::path& file : fixtures){
+        templates.push_back(readFile(file));
+    }
+    std::vector<fs::path> corpus;
+    for(int i=0; i<corpusSize; i++){
+        fs::path file = corpusDir / ("generated" + std::to_string(i) + ".pc");
+        std::ofstream out(file.string());
+        out << "generated_id=" << i << "\n"
+            << "generated_prefix=${prefix}/generated/${generated_id}\n"
+            << templates[i % templates.size()];
+        corpus.push_back(file);
+    }
+
+    start = base::Time::now();
+    n_entries = parseAll(corpus);
+    end = base::Time::now();
+    std::cout << "Corpus: parsed " << corpus.size() << " files (" << n_entries << " entries) in "
+              << (end - start).toSeconds() << " Seconds, "
+              << (end - start).toMicroseconds() / corpus.size() << " us per file" << std::endl;
+
+    fs::remove_all(corpusDir);
+    return 0;
+}
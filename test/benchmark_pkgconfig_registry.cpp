@@ -0,0 +1,98 @@
+#include "PkgConfigRegistry.hpp"
+#include <base/Time.hpp>
+#include <iostream>
+#include <stdlib.h>
+
+using namespace orocos_cpp;
+
+//! Micro-benchmark for the file name classification of PkgConfigRegistry
+//!
+//! Usage: benchmark_pkgconfig_registry [n_names] [iterations]
+//!
+//! Compares classifyFile with the chain of regular expressions
+//! (isDeploymentPkg, isProxiesPkg, ...) that was used before.
+
+class BenchmarkPkgConfigRegistry : public PkgConfigRegistry
+{
+public:
+    BenchmarkPkgConfigRegistry() : PkgConfigRegistry({}, false) {}
+
+    PkgKind classify(const std::string& filename)
+    {
+        std::string name, transport;
+        return classifyFile(filename, name, transport);
+    }
+
+    PkgKind classifyRegex(const std::string& filename)
+    {
+        std::string name, transport, arch;
+        if(isDeploymentPkg(filename, name)) return DEPLOYMENT_PKG;
+        else if(isProxiesPkg(filename, name)) return PROXIES_PKG;
+        else if(isOrogenProjectPkg(filename, name)) return OROGEN_PROJECT_PKG;
+        else if(isOrogenTasksPkg(filename, name, arch)) return OROGEN_TASKS_PKG;
+        else if(isTransportPkg(filename, name, transport, arch)) return TRANSPORT_PKG;
+        else if(isTypekitPkg(filename, name, arch)) return TYPEKIT_PKG;
+        else if(isOrocosRTTPkg(filename, arch)) return OROCOS_RTT_PKG;
+        return UNKNOWN_PKG;
+    }
+};
+
+//Names as found in the PKG_CONFIG_PATH of a typical Rock installation
+static std::vector<std::string> makeFileNames(size_t n)
+{
+    std::vector<std::string> patterns = {
+        "orogen-project-%.pc", "%-tasks-gnulinux.pc", "%-proxies.pc", "%-typekit-gnulinux.pc",
+        "%-transport-corba-gnulinux.pc", "%-transport-mqueue-gnulinux.pc",
+        "%-transport-typelib-gnulinux.pc", "orogen-%.pc", "lib%.pc", "%-viz.pc", "%.pc"
+    };
+    std::vector<std::string> names;
+    names.push_back("orocos-rtt-gnulinux.pc");
+    for(size_t i=0; names.size()<n; i++){
+        std::string name = patterns[i % patterns.size()];
+        name.replace(name.find('%'), 1, "package_" + std::to_string(i / patterns.size()));
+        names.push_back(name);
+    }
+    return names;
+}
+
+int main(int argc, char** argv)
+{
+    size_t n_names = argc > 1 ? atoi(argv[1]) : 10000;
+    size_t iterations = argc > 2 ? atoi(argv[2]) : 1;
+
+    setenv("PKG_CONFIG_PATH", "", 0);
+    BenchmarkPkgConfigRegistry reg;
+    std::vector<std::string> names = makeFileNames(n_names);
+
+    size_t mismatches = 0;
+    for(const std::string& name : names){
+        if(reg.classify(name) != reg.classifyRegex(name))
+            mismatches++;
+    }
+
+    size_t n_known = 0;
+    base::Time start = base::Time::now();
+    for(size_t i=0; i<iterations; i++){
+        for(const std::string& name : names){
+            n_known += reg.classifyRegex(name) != 0;
+        }
+    }
+    base::Time regexTime = base::Time::now() - start;
+
+    start = base::Time::now();
+    for(size_t i=0; i<iterations; i++){
+        for(const std::string& name : names){
+            n_known += reg.classify(name) != 0;
+        }
+    }
+    base::Time classifyTime = base::Time::now() - start;
+
+    size_t n = iterations * names.size();
+    std::cout << "Classified " << n << " file names (" << n_known / 2 << " packages, "
+              << mismatches << " mismatches)" << std::endl;
+    std::cout << "  regular expressions: " << regexTime.toSeconds() << " Seconds, "
+              << regexTime.toMicroseconds() / n << " us per name" << std::endl;
+    std::cout << "  classifyFile:        " << classifyTime.toSeconds() << " Seconds, "
+              << classifyTime.toMicroseconds() / n << " us per name" << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#include "TypeRegistry.hpp"
+#include <base/Time.hpp>
+#include <iostream>
+#include <stdlib.h>
+
+using namespace orocos_cpp;
+
+//! Benchmark for task state lookups
+//!
+//! Usage: benchmark_task_states [n_iterations]
+//!
+//! Loads all typekits found in the PKG_CONFIG_PATH and looks up every state
+//! of every task model by name and by ID, \p n_iterations times (default:
+//! 1000), through the TypeRegistry and through the per model state tables.
+
+class StateBenchmark : public TypeRegistry
+{
+public:
+    StateBenchmark(PkgConfigRegistryPtr pkgreg) : TypeRegistry(pkgreg) {}
+
+    void run(int n_iterations)
+    {
+        size_t n_lookups = 0;
+        unsigned id;
+        std::string name;
+
+        base::Time start = base::Time::now();
+        for(int i = 0; i < n_iterations; i++){
+            for(const auto& table : stateTables){
+                for(const auto& state : table.second->getStateIDs()){
+                    getStateID(table.first, state.first, id);
+                    getStateName(table.first, state.second, name);
+                    n_lookups += 2;
+                }
+            }
+        }
+        base::Time registryTime = base::Time::now() - start;
+
+        start = base::Time::now();
+        for(int i = 0; i < n_iterations; i++){
+            for(const auto& model : stateTables){
+                TaskStateTableConstPtr table = getStateTable(model.first);
+                for(const auto& state : table->getStateIDs()){
+                    table->getStateID(state.first, id);
+                    table->getStateName(state.second);
+                }
+            }
+        }
+        base::Time tableTime = base::Time::now() - start;
+
+        std::cout << stateTables.size() << " task models, " << n_lookups << " lookups" << std::endl;
+        std::cout << "  TypeRegistry:   " << registryTime.toSeconds() << " Seconds" << std::endl;
+        std::cout << "  TaskStateTable: " << tableTime.toSeconds() << " Seconds" << std::endl;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    int n_iterations = argc > 1 ? atoi(argv[1]) : 1000;
+
+    PkgConfigRegistryPtr pkgreg(new PkgConfigRegistry({}, true));
+    StateBenchmark benchmark(pkgreg);
+    if(!benchmark.loadTypeRegistries())
+        std::cout << "Some typekits could not be loaded" << std::endl;
+    benchmark.run(n_iterations);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "PluginHelper.hpp"
+#include "PkgConfigRegistry.hpp"
+#include "TypekitManifest.hpp"
+#include <base/Time.hpp>
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace orocos_cpp;
+
+//! Benchmark for loading the typekits and transports of all installed typekits
+//!
+//! Usage: benchmark_typekit_loading [cold|warm] [n_prefetch_workers|sequential|manifest <file>|bundle <file>]
+//!
+//! Typekits can only be loaded once per process, so each run measures one
+//! configuration. 'cold' (default) drops the libraries from the page cache
+//! before loading them, 'warm' reads them once before. 'sequential' loads
+//! the typekits one after another with loadTypekitAndTransports, otherwise
+//! loadTypekitsAndTransports prefetches them with n_prefetch_workers threads
+//! (default: one per core). 'manifest' loads the libraries listed in the
+//! given manifest file, if it is valid, and writes it otherwise. Run it twice
+//! to compare loading through the PkgConfig files with the replay.
+//! 'bundle' loads all typekits from the given typekit bundle, see
+//! PluginHelper::loadTypekitBundle. The bundle is built first if it does not
+//! exist, which is not part of the measured time.
+
+static void setCached(const std::string& path, bool cached)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return;
+    if(cached){
+        char buffer[65536];
+        while(read(fd, buffer, sizeof(buffer)) > 0);
+    }else{
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    close(fd);
+}
+
+int main(int argc, char** argv)
+{
+    bool cold = argc < 2 || std::string(argv[1]) != "warm";
+    bool sequential = argc > 2 && std::string(argv[2]) == "sequential";
+    std::string manifest = argc > 3 && std::string(argv[2]) == "manifest" ? argv[3] : "";
+    std::string bundle = argc > 3 && std::string(argv[2]) == "bundle" ? argv[3] : "";
+    unsigned n_workers = argc > 2 && !sequential && manifest.empty() && bundle.empty() ? atoi(argv[2]) : 0;
+
+    PkgConfigRegistryPtr pkgreg = PkgConfigRegistry::initialize({}, true);
+    std::vector<std::string> typekits = pkgreg->getRegisteredTypekitNames();
+    size_t n_libraries = 0;
+    for(const std::string& typekit : typekits){
+        try{
+            for(const PluginHelper::Library& library : PluginHelper::getTypekitLibraries(typekit)){
+                setCached(library.path, !cold);
+                n_libraries++;
+            }
+        }catch(std::runtime_error& ex){
+        }
+    }
+
+    if(!bundle.empty() && access(bundle.c_str(), F_OK) != 0 && !PluginHelper::buildTypekitBundle(bundle, typekits)){
+        std::cerr << "Could not build typekit bundle " << bundle << std::endl;
+        return 1;
+    }
+    if(!bundle.empty())
+        setCached(bundle, !cold);
+
+    base::Time start = base::Time::now();
+    bool ok = true;
+    bool replayed = false;
+    if(!bundle.empty()){
+        ok = PluginHelper::loadTypekitBundle(bundle);
+    }else if(!manifest.empty()){
+        std::string key = TypekitManifest::makeKey(PluginHelper::getDefaultTransports(), {}, true);
+        replayed = PluginHelper::replayTypekitManifest(manifest, key, n_workers);
+        if(!replayed){
+            ok = PluginHelper::loadTypekitsAndTransports(typekits, n_workers);
+            ok = PluginHelper::saveTypekitManifest(manifest, key) && ok;
+        }
+    }else if(sequential){
+        for(const std::string& typekit : typekits){
+            try{
+                PluginHelper::loadTypekitAndTransports(typekit);
+            }catch(std::runtime_error& ex){
+                ok = false;
+            }
+        }
+    }else{
+        ok = PluginHelper::loadTypekitsAndTransports(typekits, n_workers);
+    }
+    base::Time time = base::Time::now() - start;
+
+    std::cout << "Loaded " << typekits.size() << " typekits (" << n_libraries << " libraries, "
+              << (cold ? "cold" : "warm") << " start, ";
+    if(!bundle.empty())
+        std::cout << "bundled in " << bundle;
+    else if(!manifest.empty())
+        std::cout << (replayed ? "replayed from " : "recorded to ") << manifest;
+    else if(sequential)
+        std::cout << "sequential";
+    else
+        std::cout << "prefetched by " << (n_workers ? std::to_string(n_workers) : std::string("one per core")) << " workers";
+    std::cout << ") in " << time.toSeconds() << " Seconds" << (ok ? "" : ", with errors") << std::endl;
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include "TypeRegistry.hpp"
+#include <base/Time.hpp>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+using namespace orocos_cpp;
+
+//! Benchmark for loading the typelist files of all installed typekits
+//!
+//! Usage: benchmark_typelist
+//!
+//! Reports the time and the resident memory needed to build the type to
+//! typekit mapping of all typekits found in the PKG_CONFIG_PATH.
+
+static long residentKB()
+{
+    std::ifstream statm("/proc/self/statm");
+    long size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int main()
+{
+    PkgConfigRegistryPtr pkgreg(new PkgConfigRegistry({}, true));
+    size_t n_typekits = pkgreg->getRegisteredTypekitNames().size();
+
+    long rss = residentKB();
+    base::Time start = base::Time::now();
+    TypeRegistry reg(pkgreg);
+    bool ok = reg.enableLazyLoading();
+    base::Time time = base::Time::now() - start;
+
+    std::cout << "Loaded the typelists of " << n_typekits << " typekits" << (ok ? "" : ", with errors") << std::endl;
+    std::cout << "  " << time.toSeconds() << " Seconds, " << residentKB() - rss << " kB" << std::endl;
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include "TypeRegistry.hpp"
+#include <typelib/registry.hh>
+#include <base/Time.hpp>
+#include <iostream>
+#include <stdlib.h>
+
+using namespace orocos_cpp;
+
+//! Benchmark for loading the type registries of all installed typekits
+//!
+//! Usage: benchmark_typeregistry [n_workers]
+//!
+//! Loads all typekits found in the PKG_CONFIG_PATH one after another and
+//! with \p n_workers threads (default: one per core) and compares the time
+//! and the resulting registries.
+
+int main(int argc, char** argv)
+{
+    unsigned n_workers = argc > 1 ? atoi(argv[1]) : 0;
+
+    PkgConfigRegistryPtr pkgreg(new PkgConfigRegistry({}, true));
+    std::vector<std::string> typekits = pkgreg->getRegisteredTypekitNames();
+
+    base::Time start = base::Time::now();
+    TypeRegistry serial(pkgreg);
+    bool serialOk = serial.loadTypekitRegistries(typekits, 1);
+    base::Time serialTime = base::Time::now() - start;
+
+    start = base::Time::now();
+    TypeRegistry parallel(pkgreg);
+    bool parallelOk = parallel.loadTypekitRegistries(typekits, n_workers);
+    base::Time parallelTime = base::Time::now() - start;
+
+    bool same = serial.registry->isSame(*parallel.registry) &&
+                serial.loadedTypekits == parallel.loadedTypekits;
+    std::cout << "Loaded " << typekits.size() << " typekits, " << serial.registry->size() << " types"
+              << (same ? "" : " (RESULTS DIFFER)") << std::endl;
+    std::cout << "  serial:   " << serialTime.toSeconds() << " Seconds" << (serialOk ? "" : ", with errors") << std::endl;
+    std::cout << "  parallel: " << parallelTime.toSeconds() << " Seconds" << (parallelOk ? "" : ", with errors") << std::endl;
+    return same ? 0 : 1;
+}
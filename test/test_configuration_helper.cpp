@@ -21,6 +21,8 @@
 #include <rtt/typelib/TypelibMarshaller.hpp>
 #include <rtt/typelib/TypelibMarshaller.hpp>
 #include <base/typekit/Types.hpp>
+#include <base/Eigen.hpp>
+#include <rtt/Property.hpp>
 
 
 
@@ -90,3 +92,24 @@ BOOST_AUTO_TEST_CASE(test_YAMLization)
     std::cout << ys <<std::endl;
     return;
 }
+
+BOOST_AUTO_TEST_CASE(test_applyConfigOnOpaque)
+{
+    //base::Vector3d is an opaque, its intermediate /wrappers/Matrix</double,3,1>
+    //is flat. The orocos sample must still be updated from the typelib sample
+    BOOST_REQUIRE(PluginHelper::loadTypekitAndTransports("base", {"typelib"}));
+    const RTT::types::TypeInfo *typeInfo = RTT::types::Types()->type("/base/Vector3d");
+    BOOST_REQUIRE(typeInfo);
+
+    RTT::Property<base::Vector3d> property("vector", "", base::Vector3d(4.0, 5.0, 6.0));
+
+    YAML::Node docs = YAML::Load("data: [1.0, 2.0, 3.0]");
+    libConfig::YAMLConfigParser parser;
+    std::shared_ptr<libConfig::ConfigValue> conf = parser.getConfigValue(docs);
+
+    ConfigurationHelper helper;
+    BOOST_REQUIRE(helper.applyConfigValueOnDSB(property.getDataSource(), typeInfo, *conf));
+    BOOST_CHECK_EQUAL(property.get().x(), 1.0);
+    BOOST_CHECK_EQUAL(property.get().y(), 2.0);
+    BOOST_CHECK_EQUAL(property.get().z(), 3.0);
+}
@@ -3,6 +3,7 @@
 #define BOOST_AUTO_TEST_MAIN
 
 #include "orocos_cpp/orocos_cpp.hpp"
+#include "orocos_cpp/PluginHelper.hpp"
 #include <boost/bind.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/test/execution_monitor.hpp>
@@ -26,3 +27,24 @@ BOOST_AUTO_TEST_CASE(initialize)
     BOOST_CHECK_EQUAL(tkn.size(), 1);
 }
 
+BOOST_AUTO_TEST_CASE(typekit_transports)
+{
+    OrocosCpp rock;
+    OrocosCppConfig cfg;
+    cfg.init_corba = false;
+    cfg.load_typekits = false;
+    cfg.typekit_transports = {"typelib", "ros"};
+    BOOST_CHECK(!rock.initialize(cfg));
+    BOOST_CHECK(PluginHelper::getDefaultTransports() == PluginHelper::getKnownTransports());
+
+    cfg.typekit_transports = {"typelib"};
+    BOOST_CHECK(rock.initialize(cfg));
+    BOOST_CHECK(PluginHelper::getDefaultTransports() == cfg.typekit_transports);
+
+    //Transports needed by a caller are added to the default ones once
+    std::vector<std::string> expected = {"typelib", "corba"};
+    BOOST_CHECK(PluginHelper::getDefaultTransportsWith("corba") == expected);
+    BOOST_CHECK(PluginHelper::getDefaultTransportsWith("typelib") == cfg.typekit_transports);
+
+    BOOST_CHECK(PluginHelper::setDefaultTransports(PluginHelper::getKnownTransports()));
+}
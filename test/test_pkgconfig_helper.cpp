@@ -8,6 +8,8 @@
 
 #include "PkgConfigHelper.hpp"
 #include <stdlib.h>
+#include <fstream>
+#include <boost/filesystem.hpp>
 
 using namespace orocos_cpp;
 
@@ -94,3 +96,41 @@ BOOST_AUTO_TEST_CASE(oldParsePkgConfigStillWorking)
 
     BOOST_ASSERT(res.size() == 2);
 }
+
+BOOST_AUTO_TEST_CASE(variableResolutionOrder)
+{
+    boost::filesystem::path file = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("orocos_cpp_%%%%-%%%%.pc");
+    {
+        std::ofstream out(file.string());
+        //Variables refer to variables defined later and sorted after them
+        out << "a_libdir=${b_prefix}/lib\n"
+            << "b_prefix=${c_root}/install\n"
+            << "c_root=/opt\n"
+            << "Libs: -L${a_libdir}\n";
+    }
+    std::map<std::string,std::string> variables;
+    std::map<std::string,std::string> properties;
+    BOOST_CHECK(PkgConfigHelper::parsePkgConfig(file.string(), variables, properties));
+    BOOST_CHECK_EQUAL(variables["a_libdir"], "/opt/install/lib");
+    BOOST_CHECK_EQUAL(variables["b_prefix"], "/opt/install");
+    BOOST_CHECK_EQUAL(properties["Libs"], "-L/opt/install/lib");
+
+    //Cyclic and undefined references are reported and kept
+    {
+        std::ofstream out(file.string());
+        out << "a=${b}\n"
+            << "b=x${a}\n"
+            << "c=${undefined}/${c}\n"
+            << "d=${prefix}\n"
+            << "prefix=/opt\n";
+    }
+    variables.clear();
+    properties.clear();
+    BOOST_CHECK(!PkgConfigHelper::parsePkgConfig(file.string(), variables, properties));
+    BOOST_CHECK_EQUAL(variables["a"], "x${a}");
+    BOOST_CHECK_EQUAL(variables["b"], "x${a}");
+    BOOST_CHECK_EQUAL(variables["c"], "${undefined}/${c}");
+    BOOST_CHECK_EQUAL(variables["d"], "/opt");
+
+    boost::filesystem::remove(file);
+}
@@ -8,6 +8,10 @@
 
 #include <orocos_cpp/PkgConfigRegistry.hpp>
 #include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <thread>
+#include <atomic>
 
 using namespace orocos_cpp;
 BOOST_AUTO_TEST_CASE(loadAllPackages)
@@ -95,3 +99,351 @@ BOOST_AUTO_TEST_CASE(loadNamedPackages)
     BOOST_CHECK(reg.getOrogen("gibt'snicht", oro) == false);
 }
 
+BOOST_AUTO_TEST_CASE(loadAllPackagesCached)
+{
+    int ret = putenv("PKG_CONFIG_PATH=../../test/test_pkgconfig");
+    fs::path cacheFile = fs::temp_directory_path() / fs::unique_path("orocos_cpp_pkgconfig_cache_%%%%-%%%%");
+
+    //First run creates the cache, second run restores it
+    PkgConfigRegistry scanned({}, true, cacheFile.string());
+    BOOST_CHECK(fs::exists(cacheFile));
+    PkgConfigRegistry cached({}, true, cacheFile.string());
+
+    BOOST_CHECK(cached.getRegisteredOrogenNames() == scanned.getRegisteredOrogenNames());
+    BOOST_CHECK(cached.getRegisteredDeploymentNames() == scanned.getRegisteredDeploymentNames());
+    BOOST_CHECK(cached.getRegisteredTypekitNames() == scanned.getRegisteredTypekitNames());
+
+    PkgConfig pkg;
+    std::string val;
+    BOOST_CHECK(cached.getDeployment("ping_pong_aba_a", pkg, false));
+    BOOST_CHECK(pkg.getVariable("project_name", val));
+    BOOST_CHECK_EQUAL(val, "rrt_evaluation_deployments");
+
+    TypekitPkgConfig typ;
+    BOOST_CHECK(cached.getTypekit("aggregator", typ, false));
+    BOOST_CHECK_EQUAL(typ.transports.size(), 3);
+    BOOST_CHECK(typ.transports["corba"].getProperty("Name", val));
+    BOOST_CHECK_EQUAL(val, "aggregatorCorbaTransport");
+
+    OrogenPkgConfig oro;
+    BOOST_CHECK(cached.getOrogen("execution", oro, false));
+    BOOST_CHECK(oro.tasks.isLoaded());
+    BOOST_CHECK(oro.proxies.isLoaded());
+
+    //A cache for different search paths must not be used
+    ret = putenv("PKG_CONFIG_PATH=../../test");
+    PkgConfigRegistry other({}, true, cacheFile.string());
+    BOOST_CHECK(other.getRegisteredDeploymentNames().empty());
+
+    fs::remove(cacheFile);
+}
+
+BOOST_AUTO_TEST_CASE(loadAllPackagesParallel)
+{
+    int ret = putenv("PKG_CONFIG_PATH=../../test/test_pkgconfig:../../test:../../test/./test_pkgconfig");
+    PkgConfigRegistry serial({}, true);
+    PkgConfigRegistry parallel({}, true, "", 4);
+
+    BOOST_CHECK(parallel.getRegisteredOrogenNames() == serial.getRegisteredOrogenNames());
+    BOOST_CHECK(parallel.getRegisteredDeploymentNames() == serial.getRegisteredDeploymentNames());
+    BOOST_CHECK(parallel.getRegisteredTypekitNames() == serial.getRegisteredTypekitNames());
+
+    //First search path wins for duplicates
+    PkgConfig pkg;
+    BOOST_CHECK(parallel.getDeployment("ping_pong_aba_a", pkg, false));
+    BOOST_CHECK_EQUAL(pkg.sourceFile, "../../test/test_pkgconfig/orogen-ping_pong_aba_a.pc");
+
+    TypekitPkgConfig typ;
+    BOOST_CHECK(parallel.getTypekit("aggregator", typ, false));
+    BOOST_CHECK_EQUAL(typ.transports.size(), 3);
+    BOOST_CHECK_EQUAL(typ.transports["corba"].sourceFile, "../../test/test_pkgconfig/aggregator-transport-corba-gnulinux.pc");
+
+    OrogenPkgConfig oro;
+    BOOST_CHECK(parallel.getOrogen("execution", oro, false));
+    BOOST_CHECK(oro.project.isLoaded());
+    BOOST_CHECK(oro.proxies.isLoaded());
+    BOOST_CHECK(oro.tasks.isLoaded());
+    BOOST_CHECK(parallel.getOrocosRTT(pkg, false));
+}
+
+//Gives access to the file name classification of PkgConfigRegistry
+class ClassifyingPkgConfigRegistry : public PkgConfigRegistry
+{
+public:
+    ClassifyingPkgConfigRegistry() : PkgConfigRegistry({}, false) {}
+
+    std::string classify(const std::string& filename)
+    {
+        std::string name, transport;
+        PkgKind kind = classifyFile(filename, name, transport);
+        return std::to_string(kind) + " " + name + " " + transport;
+    }
+
+    //Reference implementation with the regular expressions
+    std::string classifyRegex(const std::string& filename)
+    {
+        std::string name, transport, arch;
+        PkgKind kind = UNKNOWN_PKG;
+        if(isDeploymentPkg(filename, name)) kind = DEPLOYMENT_PKG;
+        else if(isProxiesPkg(filename, name)) kind = PROXIES_PKG;
+        else if(isOrogenProjectPkg(filename, name)) kind = OROGEN_PROJECT_PKG;
+        else if(isOrogenTasksPkg(filename, name, arch)) kind = OROGEN_TASKS_PKG;
+        else if(isTransportPkg(filename, name, transport, arch)) kind = TRANSPORT_PKG;
+        else if(isTypekitPkg(filename, name, arch)) kind = TYPEKIT_PKG;
+        else if(isOrocosRTTPkg(filename, arch)) kind = OROCOS_RTT_PKG;
+        if(kind == UNKNOWN_PKG || kind == OROCOS_RTT_PKG)
+            name.clear();
+        return std::to_string(kind) + " " + name + " " + transport;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(classifyFile)
+{
+    ClassifyingPkgConfigRegistry reg;
+    std::vector<std::string> filenames;
+    for(fs::directory_iterator it("../../test/test_pkgconfig"); it != fs::directory_iterator(); ++it){
+        filenames.push_back(it->path().filename().string());
+    }
+    std::vector<std::string> corner_cases = {
+        "orogen-project.pc", "orogen-proxies.pc", "orogen-project-tasks.pc",
+        "orogen-tasks-gnulinux.pc", "orocos-typekit-gnulinux.pc", "orocos-rtt-corba-gnulinux.pc",
+        "base-transport-typelib-gnulinux.pc", "base-transport-typelib-gnu-linux.pc",
+        "base--typekit-gnulinux.pc", "base-typekit-.pc", "-proxies.pc", "orogen-.pc",
+        "orogen-foo.pc.in", "orogen-foo", "pc", ".pc", "orogen-f.oo.pc", "base-types.pc"
+    };
+    filenames.insert(filenames.end(), corner_cases.begin(), corner_cases.end());
+
+    for(const std::string& filename : filenames){
+        BOOST_CHECK_MESSAGE(reg.classify(filename) == reg.classifyRegex(filename),
+                            filename << ": " << reg.classify(filename) << " != " << reg.classifyRegex(filename));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sharedRecords)
+{
+    int ret = putenv("PKG_CONFIG_PATH=../../test/test_pkgconfig");
+    PkgConfigRegistry reg({"aggregator"}, false);
+
+    //Lookups hand out the same record instead of copies
+    TypekitPkgConfigConstPtr typ = reg.getTypekit("aggregator");
+    BOOST_REQUIRE(typ);
+    BOOST_CHECK(typ == reg.getTypekit("aggregator"));
+    std::string val;
+    BOOST_CHECK(typ->typekit.getVariable("project_name", val));
+    BOOST_CHECK_EQUAL(val, "aggregator");
+    BOOST_CHECK(!typ->typekit.getVariable("gibt'snicht", val));
+
+    //Loading further packages does not touch records that were handed out
+    OrogenPkgConfigConstPtr oro = reg.getOrogen("aggregator");
+    BOOST_REQUIRE(oro);
+    BOOST_CHECK(reg.getOrogen("execution"));
+    BOOST_CHECK(oro == reg.getOrogen("aggregator"));
+
+    BOOST_CHECK(!reg.getDeployment("gibt'snicht"));
+    BOOST_CHECK(!reg.getOrocosRTT(false));
+    BOOST_CHECK(reg.getOrocosRTT());
+}
+
+BOOST_AUTO_TEST_CASE(refreshDirectoryIndex)
+{
+    fs::path dir = fs::temp_directory_path() / fs::unique_path("orocos_cpp_pkgconfig_%%%%-%%%%");
+    fs::create_directories(dir);
+    std::string env = "PKG_CONFIG_PATH=" + dir.string() + ":../../test/test_pkgconfig";
+    int ret = putenv(&env[0]);
+    PkgConfigRegistry reg({}, false);
+    BOOST_CHECK(!reg.getDeployment("installed_later"));
+
+    //The search paths were indexed by the first lookup, new files are only
+    //seen after refreshing the index
+    fs::copy_file("../../test/test_pkgconfig/orogen-ping_pong_aba_a.pc", dir / "orogen-installed_later.pc");
+    BOOST_CHECK(!reg.getDeployment("installed_later"));
+    reg.refreshDirectoryIndex();
+    BOOST_CHECK(reg.getDeployment("installed_later"));
+
+    ret = putenv("PKG_CONFIG_PATH=../../test/test_pkgconfig");
+    fs::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(missingPackages)
+{
+    int ret = putenv("PKG_CONFIG_PATH=../../test/test_pkgconfig");
+    PkgConfigRegistry reg({}, false);
+
+    //Only the first lookup searches
+    BOOST_CHECK(!reg.getOrogen("gibt'snicht"));
+    BOOST_CHECK(!reg.getOrogen("gibt'snicht"));
+    BOOST_CHECK(!reg.getOrogen("gibt'snicht"));
+    BOOST_CHECK_EQUAL(reg.getLookupStatistics().rescans, 1);
+    BOOST_CHECK_EQUAL(reg.getLookupStatistics().avoidedRescans, 2);
+
+    //Missing packages are remembered per kind. 'execution' has no typekit
+    BOOST_CHECK(!reg.getTypekit("execution"));
+    BOOST_CHECK(reg.getOrogen("execution"));
+    BOOST_CHECK(!reg.getTypekit("execution"));
+    BOOST_CHECK_EQUAL(reg.getLookupStatistics().rescans, 2);
+    BOOST_CHECK_EQUAL(reg.getLookupStatistics().avoidedRescans, 3);
+
+    reg.forgetMissingPackages();
+    BOOST_CHECK(!reg.getOrogen("gibt'snicht"));
+    BOOST_CHECK_EQUAL(reg.getLookupStatistics().rescans, 3);
+
+    reg.setMissingPackageTTL(0.01);
+    usleep(20000);
+    BOOST_CHECK(!reg.getOrogen("gibt'snicht"));
+    BOOST_CHECK_EQUAL(reg.getLookupStatistics().rescans, 4);
+    BOOST_CHECK_EQUAL(reg.getLookupStatistics().avoidedRescans, 3);
+}
+
+BOOST_AUTO_TEST_CASE(watchSearchPaths)
+{
+    fs::path dir = fs::temp_directory_path() / fs::unique_path("orocos_cpp_pkgconfig_%%%%-%%%%");
+    fs::create_directories(dir);
+    std::string env = "PKG_CONFIG_PATH=" + dir.string() + ":../../test/test_pkgconfig";
+    int ret = putenv(&env[0]);
+    PkgConfigRegistry reg({}, true);
+    BOOST_CHECK(reg.watchSearchPaths());
+    BOOST_CHECK_EQUAL(reg.processSearchPathChanges(), 0);
+    PkgConfigConstPtr fixture = reg.getDeployment("ping_pong_aba_a", false);
+    BOOST_REQUIRE(fixture);
+
+    //Installed packages show up without rescanning
+    fs::copy_file("../../test/test_pkgconfig/orogen-ping_pong_aba_a.pc", dir / "orogen-installed_later.pc");
+    BOOST_CHECK(reg.getDeployment("installed_later", false));
+
+    //A file in an earlier search path shadows the installed one
+    {
+        std::ofstream out((dir / "orogen-ping_pong_aba_a.pc").string());
+        out << "project_name=shadowed\nName: ping_pong_aba_a\n";
+    }
+    std::string project;
+    PkgConfigConstPtr shadowed = reg.getDeployment("ping_pong_aba_a", false);
+    BOOST_REQUIRE(shadowed);
+    BOOST_CHECK(shadowed->getVariable("project_name", project));
+    BOOST_CHECK_EQUAL(project, "shadowed");
+    BOOST_CHECK(fixture->getVariable("project_name", project));
+    BOOST_CHECK_EQUAL(project, "rrt_evaluation_deployments");
+
+    //Removing it falls back to the installed one
+    fs::remove(dir / "orogen-ping_pong_aba_a.pc");
+    BOOST_CHECK_EQUAL(reg.getDeployment("ping_pong_aba_a", false)->sourceFile, fixture->sourceFile);
+
+    //Removed packages disappear
+    fs::remove(dir / "orogen-installed_later.pc");
+    BOOST_CHECK(!reg.getDeployment("installed_later", false));
+
+    //Changes are ignored after stopping to watch
+    reg.stopWatchingSearchPaths();
+    fs::copy_file("../../test/test_pkgconfig/orogen-ping_pong_aba_a.pc", dir / "orogen-installed_later.pc");
+    BOOST_CHECK(!reg.getDeployment("installed_later", false));
+
+    ret = putenv("PKG_CONFIG_PATH=../../test/test_pkgconfig");
+    fs::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(watchSearchPathsOverflow)
+{
+    fs::path dir = fs::temp_directory_path() / fs::unique_path("orocos_cpp_pkgconfig_%%%%-%%%%");
+    fs::create_directories(dir);
+    std::string env = "PKG_CONFIG_PATH=" + dir.string() + ":../../test/test_pkgconfig";
+    int ret = putenv(&env[0]);
+    PkgConfigRegistry reg({}, true);
+    BOOST_CHECK(reg.watchSearchPaths());
+    fs::copy_file("../../test/test_pkgconfig/orogen-ping_pong_aba_a.pc", dir / "orogen-removed_later.pc");
+    BOOST_CHECK(reg.getDeployment("removed_later", false));
+
+    //Overflow the inotify queue, so that the following changes are lost
+    size_t maxEvents = 16384;
+    std::ifstream("/proc/sys/fs/inotify/max_queued_events") >> maxEvents;
+    for(size_t i = 0; i <= maxEvents; i++){
+        std::ofstream((dir / ("flood_" + std::to_string(i))).string());
+    }
+    fs::copy_file("../../test/test_pkgconfig/orogen-ping_pong_aba_a.pc", dir / "orogen-installed_later.pc");
+    fs::remove(dir / "orogen-removed_later.pc");
+
+    //The search paths are rescanned
+    BOOST_CHECK(reg.getDeployment("installed_later", false));
+    BOOST_CHECK(!reg.getDeployment("removed_later", false));
+    BOOST_CHECK(reg.getDeployment("ping_pong_aba_a", false));
+
+    ret = putenv("PKG_CONFIG_PATH=../../test/test_pkgconfig");
+    fs::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(concurrentLookups)
+{
+    int ret = putenv("PKG_CONFIG_PATH=../../test/test_pkgconfig");
+    PkgConfigRegistry reg({}, false);
+    const size_t nThreads = 8;
+    const size_t nIterations = 2000;
+
+    //All threads race on loading the same packages
+    std::atomic<size_t> failures(0);
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < nThreads; t++){
+        threads.push_back(std::thread([&reg, &failures, t](){
+            for(size_t i = 0; i < nIterations; i++){
+                switch((i + t) % 6){
+                case 0: failures += !reg.getDeployment("ping_pong_aba_a"); break;
+                case 1: failures += !reg.getOrogen("execution"); break;
+                case 2: failures += !reg.getTypekit("aggregator"); break;
+                case 3: failures += !reg.getOrocosRTT(); break;
+                case 4: failures += bool(reg.getOrogen("gibt'snicht")); break;
+                case 5: failures += reg.getRegisteredOrogenNames().size() > 2; break;
+                }
+            }
+        }));
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    BOOST_CHECK_EQUAL(failures, 0);
+
+    //Each package was searched exactly once
+    BOOST_CHECK_EQUAL(reg.getLookupStatistics().rescans, 5);
+    BOOST_CHECK_EQUAL(reg.getRegisteredDeploymentNames().size(), 1);
+    BOOST_CHECK_EQUAL(reg.getRegisteredOrogenNames().size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(deployedTaskIndexes)
+{
+    fs::path dir = fs::temp_directory_path() / fs::unique_path("orocos_cpp_pkgconfig_%%%%-%%%%");
+    fs::create_directories(dir);
+    std::string env = "PKG_CONFIG_PATH=" + dir.string() + ":../../test/test_pkgconfig";
+    int ret = putenv(&env[0]);
+    PkgConfigRegistry reg({}, true);
+    BOOST_CHECK(reg.watchSearchPaths());
+
+    std::vector<DeployedTask> tasks = reg.getDeployedTasksOfModel("rock_runtime_evaluation::MessageProducer");
+    BOOST_REQUIRE_EQUAL(tasks.size(), 1);
+    BOOST_CHECK_EQUAL(tasks[0].deployment, "ping_pong_aba_a");
+    BOOST_CHECK_EQUAL(tasks[0].task, "producer");
+    BOOST_CHECK(reg.getDeployedTasksOfModel("gibt::snicht").empty());
+
+    DeployedTask task;
+    BOOST_CHECK(reg.getDeployedTask("consumer", task));
+    BOOST_CHECK_EQUAL(task.deployment, "ping_pong_aba_a");
+    BOOST_CHECK_EQUAL(task.model, "rock_runtime_evaluation::MessageConsumer");
+    BOOST_CHECK(!reg.getDeployedTask("gibt'snicht", task));
+
+    std::vector<DeployedTask> deployed = reg.getDeployedTasks("ping_pong_aba_a");
+    BOOST_REQUIRE_EQUAL(deployed.size(), 2);
+    BOOST_CHECK_EQUAL(deployed[0].task, "consumer");
+    BOOST_CHECK_EQUAL(deployed[1].task, "producer");
+    BOOST_CHECK_EQUAL(deployed[1].model, "rock_runtime_evaluation::MessageProducer");
+    BOOST_CHECK(reg.getDeployedTasks("gibt'snicht").empty());
+
+    //The indexes follow installed and removed deployments
+    {
+        std::ofstream out((dir / "orogen-second_deployment.pc").string());
+        out << "deployed_tasks_with_models=second_producer,rock_runtime_evaluation::MessageProducer\n";
+    }
+    BOOST_CHECK_EQUAL(reg.getDeployedTasksOfModel("rock_runtime_evaluation::MessageProducer").size(), 2);
+    BOOST_CHECK(reg.getDeployedTask("second_producer", task));
+    BOOST_CHECK_EQUAL(task.deployment, "second_deployment");
+    fs::remove(dir / "orogen-second_deployment.pc");
+    BOOST_CHECK_EQUAL(reg.getDeployedTasksOfModel("rock_runtime_evaluation::MessageProducer").size(), 1);
+    BOOST_CHECK(!reg.getDeployedTask("second_producer", task));
+
+    ret = putenv("PKG_CONFIG_PATH=../../test/test_pkgconfig");
+    fs::remove_all(dir);
+}
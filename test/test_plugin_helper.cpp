@@ -0,0 +1,62 @@
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE "test_plugin_helper"
+#define BOOST_AUTO_TEST_MAIN
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/execution_monitor.hpp>
+
+#include <orocos_cpp/PluginHelper.hpp>
+#include <orocos_cpp/PkgConfigRegistry.hpp>
+#include <stdlib.h>
+
+using namespace orocos_cpp;
+
+//The PkgConfigRegistry can only be initialized once per process
+struct Fixture
+{
+    Fixture()
+    {
+        putenv((char*)"PKG_CONFIG_PATH=../../test/test_pkgconfig:../../test/test_pkgconfig_typekits");
+        PkgConfigRegistry::initialize({}, true);
+    }
+};
+BOOST_GLOBAL_FIXTURE(Fixture);
+
+BOOST_AUTO_TEST_CASE(requiredTypekits)
+{
+    std::vector<std::string> expected = {"sensors", "base"};
+    BOOST_CHECK(PluginHelper::getRequiredTypekits("controllers") == expected);
+    expected = {"base"};
+    BOOST_CHECK(PluginHelper::getRequiredTypekits("sensors") == expected);
+    //orocos-rtt-gnulinux is no typekit package
+    BOOST_CHECK(PluginHelper::getRequiredTypekits("base").empty());
+    //Requires only the aggregator package
+    BOOST_CHECK(PluginHelper::getRequiredTypekits("aggregator").empty());
+    BOOST_CHECK(PluginHelper::getRequiredTypekits("rtt-types").empty());
+}
+
+BOOST_AUTO_TEST_CASE(loadOrder)
+{
+    //Each typekit comes after the ones it requires, each only once
+    PluginHelper::TypekitLoadPlan plan = PluginHelper::getTypekitLoadPlan({"controllers", "aggregator", "sensors", "controllers"});
+    std::vector<std::string> expected = {"base", "sensors", "controllers", "aggregator"};
+    BOOST_CHECK(plan.typekits == expected);
+    BOOST_CHECK(plan.transports == PluginHelper::getDefaultTransports());
+
+    //Aliases of the RTT typekit are loaded once, as rtt-types
+    plan = PluginHelper::getTypekitLoadPlan({"orocos", "base", "rtt-types", "rtt"});
+    expected = {"rtt-types", "base"};
+    BOOST_CHECK(plan.typekits == expected);
+
+    //Cycles are broken, the typekits are still listed once
+    plan = PluginHelper::getTypekitLoadPlan({"cycle_a"});
+    expected = {"cycle_b", "cycle_a"};
+    BOOST_CHECK(plan.typekits == expected);
+}
+
+BOOST_AUTO_TEST_CASE(neededTypekits)
+{
+    //The 'orocos' typekit of the PkgConfig file is the RTT typekit
+    std::vector<std::string> expected = {"execution", "base", "rtt-types", "std"};
+    BOOST_CHECK(PluginHelper::getNeededTypekits("execution") == expected);
+}
@@ -0,0 +1,156 @@
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_MODULE "test_typekit_manifest"
+#define BOOST_AUTO_TEST_MAIN
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/execution_monitor.hpp>
+#include <boost/filesystem.hpp>
+
+#include <orocos_cpp/TypekitManifest.hpp>
+#include <stdlib.h>
+#include <fstream>
+
+using namespace orocos_cpp;
+namespace fs = boost::filesystem;
+
+//Directory with fake libraries in lib and PkgConfig files in pkgconfig, which
+//is the only PkgConfig search path
+struct Fixture
+{
+    fs::path dir;
+    std::string manifestFile;
+    std::string key;
+    std::vector<TypekitManifest::Entry> entries;
+
+    Fixture()
+    {
+        dir = fs::temp_directory_path() / fs::unique_path("orocos_cpp_manifest_%%%%-%%%%");
+        fs::create_directories(dir / "lib");
+        fs::create_directories(dir / "pkgconfig");
+        setenv("PKG_CONFIG_PATH", (dir / "pkgconfig").string().c_str(), 1);
+        writeFile("pkgconfig/base-typekit-gnulinux.pc", "Name: baseTypekit\n");
+        writeFile("pkgconfig/base-transport-corba-gnulinux.pc", "Name: baseCorbaTransport\n");
+        writeFile("lib/libbase-typekit-gnulinux.so", "typekit");
+        writeFile("lib/libbase-transport-corba-gnulinux.so", "transport");
+        manifestFile = (dir / "typekits.manifest").string();
+        key = TypekitManifest::makeKey({"corba"}, {}, true);
+
+        entries.push_back(entry("base", "", "lib/libbase-typekit-gnulinux.so", "pkgconfig/base-typekit-gnulinux.pc"));
+        entries.push_back(entry("base", "corba", "lib/libbase-transport-corba-gnulinux.so", "pkgconfig/base-transport-corba-gnulinux.pc"));
+        //e.g. loaded from a bundle
+        entries.push_back(entry("base", "mqueue", "lib/libbase-typekit-gnulinux.so", ""));
+    }
+
+    ~Fixture()
+    {
+        fs::remove_all(dir);
+    }
+
+    void writeFile(const std::string& name, const std::string& content)
+    {
+        std::ofstream os((dir / name).string(), std::ios::out | std::ios::trunc);
+        os << content;
+    }
+
+    TypekitManifest::Entry entry(const std::string& typekit, const std::string& transport,
+                                 const std::string& library, const std::string& pkgConfigFile)
+    {
+        TypekitManifest::Entry e;
+        e.typekit = typekit;
+        e.transport = transport;
+        e.path = (dir / library).string();
+        e.pkgConfigFile = pkgConfigFile.empty() ? "" : (dir / pkgConfigFile).string();
+        return e;
+    }
+};
+
+BOOST_FIXTURE_TEST_CASE(saveAndLoad, Fixture)
+{
+    std::vector<TypekitManifest::Entry> loaded;
+    BOOST_CHECK_EQUAL(TypekitManifest::load(manifestFile, key, loaded), TypekitManifest::MISSING);
+
+    BOOST_REQUIRE(TypekitManifest::save(manifestFile, key, entries));
+    BOOST_REQUIRE_EQUAL(TypekitManifest::load(manifestFile, key, loaded), TypekitManifest::VALID);
+    BOOST_REQUIRE_EQUAL(loaded.size(), entries.size());
+    for(size_t i = 0; i < entries.size(); i++)
+    {
+        BOOST_CHECK_EQUAL(loaded[i].typekit, entries[i].typekit);
+        BOOST_CHECK_EQUAL(loaded[i].transport, entries[i].transport);
+        BOOST_CHECK_EQUAL(loaded[i].path, entries[i].path);
+        BOOST_CHECK_EQUAL(loaded[i].pkgConfigFile, entries[i].pkgConfigFile);
+    }
+    //No temporary files are left behind
+    BOOST_CHECK_EQUAL(std::distance(fs::directory_iterator(dir), fs::directory_iterator()), 3);
+}
+
+BOOST_FIXTURE_TEST_CASE(otherKey, Fixture)
+{
+    BOOST_REQUIRE(TypekitManifest::save(manifestFile, key, entries));
+    std::vector<TypekitManifest::Entry> loaded;
+    BOOST_CHECK_EQUAL(TypekitManifest::load(manifestFile, TypekitManifest::makeKey({"corba", "typelib"}, {}, true), loaded),
+                      TypekitManifest::OTHER_KEY);
+    BOOST_CHECK_EQUAL(TypekitManifest::load(manifestFile, TypekitManifest::makeKey({"corba"}, {"base"}, false), loaded),
+                      TypekitManifest::OTHER_KEY);
+    BOOST_CHECK(loaded.empty());
+
+    //A new package in a search path changes the key
+    BOOST_CHECK_EQUAL(TypekitManifest::makeKey({"corba"}, {}, true), key);
+    writeFile("pkgconfig/sensors-typekit-gnulinux.pc", "Name: sensorsTypekit\n");
+    BOOST_CHECK(TypekitManifest::makeKey({"corba"}, {}, true) != key);
+}
+
+BOOST_FIXTURE_TEST_CASE(corrupt, Fixture)
+{
+    std::vector<TypekitManifest::Entry> loaded;
+
+    writeFile("typekits.manifest", "");
+    BOOST_CHECK_EQUAL(TypekitManifest::load(manifestFile, key, loaded), TypekitManifest::CORRUPT);
+
+    writeFile("typekits.manifest", "orocos_cpp-typekit-manifest-1\n" + key + "\n");
+    BOOST_CHECK_EQUAL(TypekitManifest::load(manifestFile, key, loaded), TypekitManifest::CORRUPT);
+
+    BOOST_REQUIRE(TypekitManifest::save(manifestFile, key, entries));
+    std::ofstream os(manifestFile, std::ios::out | std::ios::app);
+    os << "base\tcorba\n";
+    os.close();
+    BOOST_CHECK_EQUAL(TypekitManifest::load(manifestFile, key, loaded), TypekitManifest::CORRUPT);
+    BOOST_CHECK(loaded.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(outdated, Fixture)
+{
+    std::vector<TypekitManifest::Entry> loaded;
+
+    //Rebuilt library
+    BOOST_REQUIRE(TypekitManifest::save(manifestFile, key, entries));
+    writeFile("lib/libbase-transport-corba-gnulinux.so", "rebuilt transport");
+    BOOST_CHECK_EQUAL(TypekitManifest::load(manifestFile, key, loaded), TypekitManifest::OUTDATED);
+
+    //Typekit reinstalled to another libdir, the PkgConfig file is rewritten
+    //in place and the old library is still there
+    BOOST_REQUIRE(TypekitManifest::save(manifestFile, key, entries));
+    BOOST_REQUIRE_EQUAL(TypekitManifest::load(manifestFile, key, loaded), TypekitManifest::VALID);
+    writeFile("pkgconfig/base-typekit-gnulinux.pc", "libdir=/opt/other\nName: baseTypekit\n");
+    BOOST_CHECK_EQUAL(TypekitManifest::load(manifestFile, key, loaded), TypekitManifest::OUTDATED);
+
+    //Removed library
+    BOOST_REQUIRE(TypekitManifest::save(manifestFile, key, entries));
+    fs::remove(dir / "lib/libbase-typekit-gnulinux.so");
+    BOOST_CHECK_EQUAL(TypekitManifest::load(manifestFile, key, loaded), TypekitManifest::OUTDATED);
+}
+
+BOOST_FIXTURE_TEST_CASE(bundleKey, Fixture)
+{
+    writeFile("lib/bundle.so", "bundle");
+    const std::string bundleFile = (dir / "lib/bundle.so").string();
+    const std::string bundleKey = TypekitManifest::makeBundleKey(bundleFile);
+    BOOST_CHECK(bundleKey != key);
+    BOOST_CHECK_EQUAL(TypekitManifest::makeBundleKey(bundleFile), bundleKey);
+
+    //A rebuilt bundle does not match the manifest written for the old one
+    BOOST_REQUIRE(TypekitManifest::save(manifestFile, bundleKey, entries));
+    writeFile("lib/bundle.so", "rebuilt bundle");
+    std::vector<TypekitManifest::Entry> loaded;
+    BOOST_CHECK_EQUAL(TypekitManifest::load(manifestFile, TypekitManifest::makeBundleKey(bundleFile), loaded),
+                      TypekitManifest::OTHER_KEY);
+}
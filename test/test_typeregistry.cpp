@@ -7,6 +7,10 @@
 #include <boost/test/execution_monitor.hpp>  
 
 #include <orocos_cpp/TypeRegistry.hpp>
+#include <orocos_cpp/FlatLayout.hpp>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <stdlib.h>
 
 using namespace orocos_cpp;
 
@@ -16,22 +20,28 @@ class TypeRegistryTest: public TypeRegistry
 public:
     TypeRegistryTest(): TypeRegistry(PkgConfigRegistryPtr(new PkgConfigRegistry({}, false))){}
 
-    void loadStatesFromCustomPath(const std::string &path)
+    void loadImportedStates()
     {
-        loadStateToIDMapping(path);
+        loadImportedStateTables();
     }
 
     void loadTypesFromCustomPath(const std::string &path, const std::string &typekitName)
     {
         loadTypeToTypekitMapping(path, typekitName);
     }
+
+    bool loadTlbFromCustomPath(const std::string &path)
+    {
+        return loadTypelibRegistry(path);
+    }
 };
 
 struct Fixture
 {
     Fixture()
     {
-        type_registries.loadStatesFromCustomPath("testfile.tlb");
+        type_registries.loadTlbFromCustomPath("testfile.tlb");
+        type_registries.loadImportedStates();
         type_registries.loadTypesFromCustomPath("testfile.typelist", "auv_control");
     }
 
@@ -67,3 +77,243 @@ BOOST_FIXTURE_TEST_CASE(test_typeregistry_typeToTypekit, Fixture)
     BOOST_CHECK(type_registries.getTypekitDefiningType("/auv_control/PIDState", typekitName));
     BOOST_CHECK_EQUAL(typekitName, "auv_control");
 }
+
+struct TypekitFixture
+{
+    //Provides the test files as typekit 'auv_control'
+    TypekitFixture()
+    {
+        dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("orocos_cpp_typekits_%%%%-%%%%");
+        boost::filesystem::create_directories(dir);
+        std::ofstream out((dir / "auv_control-typekit-gnulinux.pc").string());
+        out << "type_registry=" << boost::filesystem::absolute("testfile.tlb").string() << "\n";
+        out.close();
+        const char* path = getenv("PKG_CONFIG_PATH");
+        oldPkgConfigPath = path ? path : "";
+        setenv("PKG_CONFIG_PATH", dir.string().c_str(), 1);
+        setenv("OROCOS_TARGET", "gnulinux", 0);
+        pkgreg = PkgConfigRegistryPtr(new PkgConfigRegistry({}, true));
+    }
+    ~TypekitFixture()
+    {
+        setenv("PKG_CONFIG_PATH", oldPkgConfigPath.c_str(), 1);
+        boost::filesystem::remove_all(dir);
+    }
+
+    boost::filesystem::path dir;
+    std::string oldPkgConfigPath;
+    PkgConfigRegistryPtr pkgreg;
+};
+
+BOOST_FIXTURE_TEST_CASE(test_typeregistry_cache, TypekitFixture)
+{
+    std::string cacheFile = (dir / "typeregistry.cache").string();
+    {
+        TypeRegistry reg(pkgreg);
+        BOOST_CHECK(reg.loadTypeRegistries(cacheFile));
+        BOOST_CHECK(boost::filesystem::exists(cacheFile));
+    }
+
+    //Restored from the cache
+    TypeRegistry reg(pkgreg);
+    BOOST_CHECK(reg.loadTypeRegistries(cacheFile));
+    BOOST_CHECK_EQUAL(reg.loadedTypekits.size(), 1);
+    BOOST_CHECK(reg.hasType("/auv_control/PIDState"));
+    std::string typekitName;
+    BOOST_CHECK(reg.getTypekitDefiningType("/auv_control/PIDState", typekitName));
+    BOOST_CHECK_EQUAL(typekitName, "auv_control");
+    unsigned id;
+    BOOST_CHECK(reg.getStateID("auv_control::AccelerationController", "CONTROLLING", id));
+    BOOST_CHECK_EQUAL(id, 7);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_typeregistry_parallel, TypekitFixture)
+{
+    TypeRegistry reg(pkgreg);
+    BOOST_CHECK(reg.loadTypekitRegistries({"auv_control", "gibt'snicht"}, 4) == false);
+    BOOST_CHECK_EQUAL(reg.loadedTypekits.size(), 1);
+    BOOST_CHECK(reg.hasType("/auv_control/PIDState"));
+    unsigned id;
+    BOOST_CHECK(reg.getStateID("auv_control::AccelerationController", "EXCEPTION", id));
+    BOOST_CHECK_EQUAL(id, 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_typeregistry_skipKnownTypes)
+{
+    TypeRegistryTest reg;
+    BOOST_CHECK(reg.loadTlbFromCustomPath("testfile.tlb"));
+    size_t n_types = reg.getImportStatistics().importedTypes;
+    BOOST_CHECK(n_types > 0);
+    BOOST_CHECK_EQUAL(reg.getImportStatistics().skippedTypes, 0);
+
+    //All definitions are known now
+    BOOST_CHECK(reg.loadTlbFromCustomPath("testfile.tlb"));
+    BOOST_CHECK_EQUAL(reg.getImportStatistics().importedTypes, n_types);
+    BOOST_CHECK_EQUAL(reg.getImportStatistics().skippedTypes, n_types);
+    BOOST_CHECK(reg.hasType("/auv_control/PIDState"));
+}
+
+BOOST_AUTO_TEST_CASE(test_typeregistry_skipKnownReferencedTypes)
+{
+    TypeRegistryTest reg;
+    BOOST_CHECK(reg.loadTlbFromCustomPath("testfile.tlb"));
+    size_t n_types = reg.getImportStatistics().importedTypes;
+
+    std::ifstream in("testfile.tlb");
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    size_t bodyEnd = content.rfind("</typelib>");
+    BOOST_REQUIRE(bodyEnd != std::string::npos);
+
+    //A second typekit repeats the known types and adds one that refers to
+    //them. Only the new type is imported.
+    std::string added = content.substr(0, bodyEnd) +
+        "  <compound name='/test/PIDStates' size='160'>\n"
+        "    <field name='first' offset='0' type='/auv_control/PIDState'/>\n"
+        "    <field name='others' offset='80' type='/auv_control/PIDState[1]'/>\n"
+        "  </compound>\n" + content.substr(bodyEnd);
+    {
+        std::ofstream out("testfile_added.tlb");
+        out << added;
+    }
+    BOOST_CHECK(reg.loadTlbFromCustomPath("testfile_added.tlb"));
+    BOOST_CHECK_EQUAL(reg.getImportStatistics().importedTypes, n_types + 1);
+    BOOST_CHECK_EQUAL(reg.getImportStatistics().skippedTypes, n_types);
+    BOOST_CHECK(reg.hasType("/test/PIDStates"));
+
+    //A known type with a different definition is imported again
+    size_t pos = added.find("PID.hpp:179");
+    BOOST_REQUIRE(pos != std::string::npos);
+    added.replace(pos, 11, "PID.hpp:180");
+    {
+        std::ofstream out("testfile_changed.tlb");
+        out << added;
+    }
+    BOOST_CHECK(reg.loadTlbFromCustomPath("testfile_changed.tlb"));
+    BOOST_CHECK_EQUAL(reg.getImportStatistics().importedTypes, n_types + 2);
+    BOOST_CHECK_EQUAL(reg.getImportStatistics().skippedTypes, 2 * n_types);
+
+    boost::filesystem::remove("testfile_added.tlb");
+    boost::filesystem::remove("testfile_changed.tlb");
+}
+
+BOOST_FIXTURE_TEST_CASE(test_typeregistry_stateTable, TypekitFixture)
+{
+    TypeRegistry reg(pkgreg);
+    //Loads the typekit of the model
+    TaskStateTableConstPtr table = reg.getStateTable("auv_control::AccelerationController");
+    BOOST_REQUIRE(table);
+    BOOST_CHECK_EQUAL(table->getTaskModelName(), "auv_control::AccelerationController");
+    BOOST_REQUIRE(table->getStateName(7));
+    BOOST_CHECK_EQUAL(*table->getStateName(7), "CONTROLLING");
+    BOOST_REQUIRE(table->getStateName(8));
+    BOOST_CHECK_EQUAL(*table->getStateName(8), "CONTROLLING_UNSAFE");
+    BOOST_CHECK(!table->getStateName(1000));
+    unsigned id;
+    BOOST_CHECK(table->getStateID("EXCEPTION", id));
+    BOOST_CHECK_EQUAL(id, 3);
+    BOOST_CHECK(!table->getStateID("AccelerationController_EXCEPTION", id));
+
+    std::string stateName;
+    BOOST_CHECK(reg.getStateName("auv_control::AlignedToBody", 8, stateName));
+    BOOST_CHECK_EQUAL(stateName, "CONTROLLING_UNSAFE");
+    //Only exact model names match
+    BOOST_CHECK(!reg.getStateName("auv_control::Aligned", 8, stateName));
+    BOOST_CHECK(!reg.getStateTable("auv_control::WrongModelName"));
+}
+
+BOOST_AUTO_TEST_CASE(test_typeregistry_importedStates)
+{
+    TypeRegistryTest reg;
+    BOOST_CHECK(reg.loadTlbFromCustomPath("testfile.tlb"));
+    reg.loadImportedStates();
+    std::string stateName;
+    BOOST_CHECK(reg.getStateName("auv_control::AccelerationController", 7, stateName));
+    BOOST_CHECK_EQUAL(stateName, "CONTROLLING");
+    TaskStateTableConstPtr table = reg.getStateTable("auv_control::AccelerationController");
+    BOOST_REQUIRE(table);
+
+    //Nothing new was imported, the tables are kept
+    BOOST_CHECK(reg.loadTlbFromCustomPath("testfile.tlb"));
+    reg.loadImportedStates();
+    BOOST_CHECK(reg.getStateTable("auv_control::AccelerationController") == table);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_typeregistry_lazyLoading, TypekitFixture)
+{
+    TypeRegistry reg(pkgreg);
+    BOOST_CHECK(reg.enableLazyLoading());
+    BOOST_CHECK(reg.loadedTypekits.empty());
+    std::string typekitName;
+    BOOST_CHECK(reg.getTypekitDefiningType("/auv_control/PIDState", typekitName));
+    BOOST_CHECK_EQUAL(typekitName, "auv_control");
+    BOOST_CHECK(reg.loadedTypekits.empty());
+
+    //Loads the defining typekit
+    BOOST_CHECK(reg.getTypeModel("/auv_control/PIDState"));
+    BOOST_CHECK_EQUAL(reg.loadedTypekits.size(), 1);
+    BOOST_CHECK(reg.hasType("/auv_control/PIDState"));
+    BOOST_CHECK(!reg.hasType("/auv_control/NoSuchType"));
+    BOOST_CHECK_EQUAL(reg.loadedTypekits.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_typeregistry_typelistFormat)
+{
+    boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("orocos_cpp_%%%%-%%%%.typelist");
+    {
+        std::ofstream out(path.string());
+        out << "/first/Type 0\n\nnot_a_type\n/base/Time 1\n/last/Type 0";
+    }
+    TypeRegistryTest reg;
+    reg.loadTypesFromCustomPath(path.string(), "first");
+    reg.loadTypesFromCustomPath(path.string(), "second");
+    boost::filesystem::remove(path);
+
+    std::string typekitName;
+    BOOST_CHECK(reg.getTypekitDefiningType("/first/Type", typekitName));
+    BOOST_CHECK_EQUAL(typekitName, "first");
+    //Without a trailing newline
+    BOOST_CHECK(reg.getTypekitDefiningType("/last/Type", typekitName));
+    BOOST_CHECK_EQUAL(typekitName, "first");
+    BOOST_CHECK(!reg.getTypekitDefiningType("not_a_type", typekitName));
+    BOOST_CHECK(!reg.getTypekitDefiningType("", typekitName));
+    BOOST_CHECK(reg.getTypekitDefiningType("int", typekitName));
+    BOOST_CHECK_EQUAL(typekitName, "rtt-types");
+}
+
+BOOST_FIXTURE_TEST_CASE(test_typeregistry_typeHandles, TypekitFixture)
+{
+    TypeRegistry reg(pkgreg);
+    BOOST_CHECK(reg.enableLazyLoading());
+    const TypeHandle* handle = reg.resolveType("/auv_control/PIDState");
+    BOOST_REQUIRE(handle);
+    BOOST_CHECK_EQUAL(handle->name, "/auv_control/PIDState");
+    BOOST_CHECK(handle->type == reg.getTypeModel("/auv_control/PIDState"));
+    BOOST_CHECK_EQUAL(handle->size, handle->type->getSize());
+    BOOST_CHECK(reg.resolveType("/auv_control/PIDState") == handle);
+    BOOST_CHECK(reg.getTypeHandle(handle->id) == handle);
+    BOOST_CHECK(!reg.resolveType("/auv_control/NoSuchType"));
+    BOOST_CHECK(!reg.getTypeHandle(handle->id + 1));
+}
+
+BOOST_AUTO_TEST_CASE(test_typeregistry_numericKinds)
+{
+    TypeRegistryTest reg;
+    BOOST_REQUIRE(reg.loadTlbFromCustomPath("testfile.tlb"));
+
+    const std::pair<std::string, FlatLayout::Kind> expected[] = {
+        {"/double", FlatLayout::DOUBLE},
+        {"/int32_t", FlatLayout::INT32},
+        {"/int64_t", FlatLayout::INT64},
+        //typelib encodes bools as unsigned integers
+        {"/bool", FlatLayout::UINT8},
+    };
+    for(const auto& numeric : expected)
+    {
+        const TypeHandle* handle = reg.resolveType(numeric.first);
+        BOOST_REQUIRE(handle);
+        BOOST_REQUIRE_EQUAL(handle->type->getCategory(), Typelib::Type::Numeric);
+        FlatLayout::Kind kind;
+        BOOST_REQUIRE(FlatLayout::getNumericKind(static_cast<const Typelib::Numeric&>(*handle->type), kind));
+        BOOST_CHECK_EQUAL(kind, numeric.second);
+    }
+}